@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+
+#include "mq/event/EventLoop.h"
+#include "mq/event/Timer.h"
+#include "mq/net/Endpoint.h"
+#include "mq/net/FramingSocket.h"
+#include "mq/utils/CallbackList.h"
+
+namespace mq {
+
+// Resumes the coroutine after delay. The resumption is a task on loop, so if the loop stops before the
+// delay elapses the coroutine is never resumed and a spawned task's frame is leaked.
+class SleepAwaiter {
+public:
+    SleepAwaiter(EventLoop *loop, std::chrono::nanoseconds delay)
+        : loop_(loop), delay_(delay) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop *loop_;
+    std::chrono::nanoseconds delay_;
+};
+
+// Resumes the coroutine when timer next expires. Timer::reset() drops the expire callback, so if the
+// timer is reset, or its loop stops, before it expires the coroutine is never resumed and a spawned
+// task's frame is leaked. Cancel and close do not drop it; a later expiry still resumes the coroutine.
+class ExpireAwaiter {
+public:
+    explicit ExpireAwaiter(Timer *timer)
+        : timer_(timer) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    void await_resume() const noexcept {}
+
+private:
+    Timer *timer_;
+};
+
+class ConnectAwaiter {
+public:
+    ConnectAwaiter(FramingSocket *socket, const Endpoint *remoteEndpoint)
+        : socket_(socket), remoteEndpoint_(remoteEndpoint) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle);
+
+    int await_resume() const noexcept {
+        return error_;
+    }
+
+private:
+    FramingSocket *socket_;
+    const Endpoint *remoteEndpoint_;
+    std::coroutine_handle<> handle_;
+    bool suspended_ = false;
+    bool completed_ = false;
+    int error_ = 0;
+};
+
+class SendCompleteAwaiter {
+public:
+    explicit SendCompleteAwaiter(FramingSocket *socket)
+        : socket_(socket) {}
+
+    bool await_ready();
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    int await_resume() const noexcept {
+        return error_;
+    }
+
+private:
+    FramingSocket *socket_;
+    std::coroutine_handle<> handle_;
+    CallbackId sendCompleteId_ = 0;
+    CallbackId closeId_ = 0;
+    int error_ = 0;
+};
+
+inline SleepAwaiter sleepFor(EventLoop *loop, std::chrono::nanoseconds delay) {
+    return SleepAwaiter(loop, delay);
+}
+
+inline ExpireAwaiter awaitExpire(Timer &timer) {
+    return ExpireAwaiter(&timer);
+}
+
+inline ConnectAwaiter awaitConnect(FramingSocket &socket, const Endpoint &remoteEndpoint) {
+    return ConnectAwaiter(&socket, &remoteEndpoint);
+}
+
+inline SendCompleteAwaiter awaitSendComplete(FramingSocket &socket) {
+    return SendCompleteAwaiter(&socket);
+}
+
+} // namespace mq
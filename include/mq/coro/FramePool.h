@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+
+namespace mq {
+
+class FramePool {
+public:
+    FramePool() = delete;
+
+    static void *allocate(size_t size);
+    static void deallocate(void *ptr, size_t size);
+};
+
+} // namespace mq
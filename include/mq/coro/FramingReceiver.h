@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "mq/net/FramingSocket.h"
+#include "mq/utils/Empty.h"
+
+namespace mq {
+
+class FramingReceiver {
+public:
+    class RecvAwaiter {
+    public:
+        explicit RecvAwaiter(FramingReceiver *receiver)
+            : receiver_(receiver) {}
+
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> handle);
+        std::optional<std::string> await_resume();
+
+    private:
+        FramingReceiver *receiver_;
+    };
+
+    explicit FramingReceiver(FramingSocket *socket);
+    ~FramingReceiver();
+
+    FramingReceiver(const FramingReceiver &) = delete;
+    FramingReceiver(FramingReceiver &&) = delete;
+
+    FramingReceiver &operator=(const FramingReceiver &) = delete;
+    FramingReceiver &operator=(FramingReceiver &&) = delete;
+
+    bool closed() const {
+        return closed_;
+    }
+
+    int error() const {
+        return error_;
+    }
+
+    RecvAwaiter recv() {
+        return RecvAwaiter(this);
+    }
+
+private:
+    FramingSocket *socket_;
+    std::deque<std::string> messages_;
+    std::coroutine_handle<> waiter_;
+    bool closed_ = false;
+    int error_ = 0;
+    std::shared_ptr<Empty> token_;
+
+    void onSocketRecv(std::string_view message);
+    void onSocketClose(int error);
+};
+
+} // namespace mq
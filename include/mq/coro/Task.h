@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "mq/coro/FramePool.h"
+#include "mq/event/EventLoop.h"
+
+namespace mq {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+public:
+    static void *operator new(size_t size) {
+        return FramePool::allocate(size);
+    }
+
+    static void operator delete(void *ptr, size_t size) {
+        FramePool::deallocate(ptr, size);
+    }
+
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+
+    class FinalAwaiter {
+    public:
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            return handle.promise().continuation_;
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+
+    void unhandled_exception() {
+        std::terminate();
+    }
+
+    void setContinuation(std::coroutine_handle<> continuation) {
+        continuation_ = continuation;
+    }
+
+private:
+    std::coroutine_handle<> continuation_ = std::noop_coroutine();
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object();
+
+    void return_value(T value) {
+        value_.emplace(std::move(value));
+    }
+
+    T result() {
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void result() {}
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : handle_(handle) {}
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    Task(const Task &) = delete;
+
+    Task(Task &&other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task &operator=(const Task &) = delete;
+    Task &operator=(Task &&) = delete;
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept {
+                return handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+                handle.promise().setContinuation(continuation);
+                return handle;
+            }
+
+            T await_resume() {
+                return handle.promise().result();
+            }
+        };
+
+        return Awaiter{handle_};
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+class DetachedTask {
+public:
+    class promise_type {
+    public:
+        static void *operator new(size_t size) {
+            return FramePool::allocate(size);
+        }
+
+        static void operator delete(void *ptr, size_t size) {
+            FramePool::deallocate(ptr, size);
+        }
+
+        DetachedTask get_return_object() noexcept {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+inline DetachedTask runDetached(Task<void> task) {
+    co_await std::move(task);
+}
+
+} // namespace detail
+
+inline void spawn(EventLoop *loop, Task<void> task) {
+    if (loop->isInLoopThread()) {
+        detail::runDetached(std::move(task));
+    } else {
+        loop->post([task = std::move(task)] mutable {
+            detail::runDetached(std::move(task));
+        });
+    }
+}
+
+} // namespace mq
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+
+#include "mq/event/Poller.h"
+
+namespace mq {
+
+class EpollPoller final : public Poller {
+public:
+    EpollPoller();
+    ~EpollPoller() override;
+
+    Backend backend() const override {
+        return Backend::kEpoll;
+    }
+
+    void add(int fd, uint32_t events, uint64_t data) override;
+    void modify(int fd, uint32_t events, uint64_t data) override;
+    void remove(int fd) override;
+    int wait(Event *events, int maxEvents, int timeout) override;
+
+private:
+    int epollFd_;
+};
+
+} // namespace mq
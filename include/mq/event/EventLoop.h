@@ -2,12 +2,20 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <format>
-#include <mutex>
-#include <unordered_map>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "mq/event/Poller.h"
+#include "mq/event/TimerQueue.h"
+#include "mq/utils/BufferPool.h"
+#include "mq/utils/Histogram.h"
+#include "mq/utils/MpscQueue.h"
 #include "mq/utils/TimedExecutor.h"
 
 namespace mq {
@@ -26,7 +34,31 @@ public:
     using Task = TimedExecutor::Task;
     using TimedTask = TimedExecutor::TimedTask;
 
+    struct Stats {
+        uint64_t iterations = 0;
+        uint64_t wakeUps = 0;
+        uint64_t events = 0;
+        uint64_t callbacks = 0;
+        uint64_t tasks = 0;
+        uint64_t taskOverflows = 0;
+        uint64_t timedTasks = 0;
+        uint64_t watcherUpdates = 0;
+        uint64_t pollerUpdates = 0;
+        uint64_t flushes = 0;
+        std::chrono::nanoseconds callbackTime{};
+        std::chrono::nanoseconds taskTime{};
+        std::chrono::nanoseconds timedTaskTime{};
+        std::chrono::nanoseconds longestCallback{};
+        std::string longestCallbackTag;
+        int longestCallbackFd = -1;
+        Histogram eventsPerIteration;
+        Histogram tasksPerIteration;
+        Histogram iterationLatency;
+        Histogram callbackLatency;
+    };
+
     EventLoop();
+    explicit EventLoop(Poller::Backend backend);
     ~EventLoop() override;
 
     EventLoop(const EventLoop &) = delete;
@@ -39,33 +71,88 @@ public:
         return loop_ == this;
     }
 
+    void setBusyPoll(std::chrono::nanoseconds busyPoll);
+    void setStatsDumpInterval(std::chrono::nanoseconds statsDumpInterval);
+    void setBufferPoolBudget(size_t bufferPoolBudget);
+
     State state() const;
+    Poller::Backend backend() const;
+    BufferPool *bufferPool();
+    Stats stats() const;
+    void resetStats();
     void post(Task task) override;
     void postTimed(TimedTask task, std::chrono::nanoseconds delay) override;
     [[noreturn]] void run();
 
     static EventLoop *background();
+    static EventLoop *background(Poller::Backend backend);
 
 private:
+    struct WatcherSlot {
+        Watcher *watcher = nullptr;
+        uint32_t generation = 0;
+        bool edgeTriggered = false;
+        bool pending = false;
+        bool dirty = false;
+        bool flushScheduled = false;
+        uint32_t readyEvents = 0;
+        uint32_t registeredEvents = 0;
+    };
+
     static thread_local EventLoop *loop_;
 
     State state_ = State::kIdle;
-    int epollFd_;
+    BufferPool bufferPool_;
+    std::unique_ptr<Poller> poller_;
     int eventFd_;
-    std::unordered_map<int, Watcher *> watchers_;
-    std::mutex watchersMutex_;
-    std::vector<Task> tasks_;
-    std::mutex tasksMutex_;
-    std::unordered_map<int, TimedTask> timedTasks_;
-    std::mutex timedTasksMutex_;
+    int timerFd_;
+    std::vector<WatcherSlot> watchers_;
+    std::vector<uint64_t> pendingWatchers_;
+    std::vector<uint64_t> readyWatchers_;
+    std::vector<uint64_t> dirtyWatchers_;
+    std::vector<uint64_t> flushWatchers_;
+    std::vector<uint64_t> flushingWatchers_;
+    MpscQueue<Task> tasks_;
+    std::vector<Task> localTasks_;
+    std::atomic<bool> sleeping_ = false;
+    TimerQueue timers_;
+    TimerQueue::Clock::time_point timerFdExpiry_ = TimerQueue::Clock::time_point::max();
+    std::chrono::nanoseconds busyPoll_{};
+    std::chrono::nanoseconds eventInterval_{};
+    TimerQueue::Clock::time_point lastEventTime_{};
+    TimerQueue::Clock::time_point busyPollDeadline_{};
+    Stats stats_;
+    std::chrono::nanoseconds statsDumpInterval_{};
+    TimerQueue::TimerId statsDumpTimerId_ = 0;
 
     bool hasWatcher(int fd);
     void addWatcher(Watcher *watcher);
     void updateWatcher(Watcher *watcher);
     void updateWatcherIfRegistered(Watcher *watcher);
     void removeWatcher(Watcher *watcher);
+    void applyWatcherUpdates();
+    void clearWatcherReady(Watcher *watcher, uint32_t events);
+    void schedulePendingWatcher(int fd);
+    void dispatchPendingWatchers();
+    void scheduleWatcherFlush(Watcher *watcher);
+    void dispatchWatcherFlushes();
+    void dispatchReadReady(Watcher *watcher);
+    void dispatchWriteReady(Watcher *watcher);
+    void dispatchError(Watcher *watcher);
+    void recordCallback(Watcher *watcher, uint64_t cycles);
+    static uint32_t watcherEvents(Watcher *watcher);
+    static uint64_t watcherData(int fd, uint32_t generation);
     void wakeUp();
 
+    TimerQueue::TimerId addTimer(TimerQueue::Clock::time_point expiry, TimedTask task);
+    void cancelTimer(TimerQueue::TimerId timerId);
+    void runTimers();
+    void setTimerFd(TimerQueue::Clock::time_point expiry);
+
+    void scheduleStatsDump();
+    void dumpStats();
+
+    friend class Timer;
     friend class Watcher;
 };
 
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "mq/event/EventLoop.h"
+
+namespace mq {
+
+class EventLoopGroup {
+public:
+    explicit EventLoopGroup(size_t numLoops = std::thread::hardware_concurrency(), bool pinned = false);
+
+    EventLoopGroup(const EventLoopGroup &) = delete;
+    EventLoopGroup(EventLoopGroup &&) = delete;
+
+    EventLoopGroup &operator=(const EventLoopGroup &) = delete;
+    EventLoopGroup &operator=(EventLoopGroup &&) = delete;
+
+    size_t size() const {
+        return loops_.size();
+    }
+
+    EventLoop *loop(size_t index) const {
+        return loops_[index];
+    }
+
+    const std::vector<EventLoop *> &loops() const {
+        return loops_;
+    }
+
+    // Returns the CPU the loop at index is pinned to, or -1 if the group is not pinned or pinning the loop
+    // failed.
+    int cpu(size_t index) const {
+        return cpus_.empty() ? -1 : cpus_[index];
+    }
+
+    EventLoop *next();
+
+private:
+    std::vector<EventLoop *> loops_;
+    std::vector<int> cpus_;
+    std::atomic<size_t> next_ = 0;
+};
+
+} // namespace mq
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+#include "mq/event/Poller.h"
+
+namespace mq {
+
+class IoUringPoller final : public Poller {
+public:
+    ~IoUringPoller() override;
+
+    Backend backend() const override {
+        return Backend::kIoUring;
+    }
+
+    void add(int fd, uint32_t events, uint64_t data) override;
+    void modify(int fd, uint32_t events, uint64_t data) override;
+    void remove(int fd) override;
+    int wait(Event *events, int maxEvents, int timeout) override;
+
+    static std::unique_ptr<IoUringPoller> create();
+
+private:
+    struct Entry {
+        uint64_t data = 0;
+        uint32_t events = 0;
+        uint32_t generation = 0;
+        bool registered = false;
+        bool armed = false;
+        bool pending = false;
+    };
+
+    int ringFd_;
+    void *ring_;
+    size_t ringSize_;
+    io_uring_sqe *sqes_;
+    size_t sqesSize_;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe *cqes_;
+    std::vector<Entry> entries_;
+    std::vector<int> pending_;
+
+    IoUringPoller() = default;
+
+    Entry &entry(int fd);
+    void arm(int fd);
+    void disarm(int fd);
+    io_uring_sqe *nextSqe();
+    int enter(unsigned minComplete, int timeout);
+};
+
+} // namespace mq
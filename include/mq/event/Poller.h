@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <memory>
+
+namespace mq {
+
+class Poller {
+public:
+    enum class Backend {
+        kEpoll,
+        kIoUring,
+    };
+
+    struct Event {
+        uint64_t data;
+        uint32_t events;
+    };
+
+    virtual ~Poller() = default;
+
+    Poller() = default;
+
+    Poller(const Poller &) = delete;
+    Poller(Poller &&) = delete;
+
+    Poller &operator=(const Poller &) = delete;
+    Poller &operator=(Poller &&) = delete;
+
+    virtual Backend backend() const = 0;
+    virtual void add(int fd, uint32_t events, uint64_t data) = 0;
+    virtual void modify(int fd, uint32_t events, uint64_t data) = 0;
+    virtual void remove(int fd) = 0;
+    virtual int wait(Event *events, int maxEvents, int timeout) = 0;
+
+    static std::unique_ptr<Poller> create(Backend backend);
+};
+
+} // namespace mq
+
+template <>
+struct std::formatter<mq::Poller::Backend> {
+    constexpr auto parse(std::format_parse_context &ctx) {
+        return ctx.begin();
+    }
+
+    template <typename FormatContext>
+    auto format(mq::Poller::Backend backend, FormatContext &ctx) const {
+        return std::format_to(ctx.out(), "{}", name(backend));
+    }
+
+private:
+    static constexpr const char *name(mq::Poller::Backend backend) {
+        using enum mq::Poller::Backend;
+
+        switch (backend) {
+            case kEpoll: return "Epoll";
+            case kIoUring: return "IoUring";
+            default: return nullptr;
+        }
+    }
+};
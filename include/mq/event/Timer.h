@@ -5,11 +5,10 @@
 #include <chrono>
 #include <format>
 #include <functional>
-#include <memory>
-#include <vector>
 
 #include "mq/event/EventLoop.h"
-#include "mq/event/Watcher.h"
+#include "mq/event/TimerQueue.h"
+#include "mq/utils/CallbackList.h"
 
 namespace mq {
 
@@ -36,9 +35,6 @@ public:
     }
 
     State state() const;
-    int fd() const;
-    Watcher &watcher();
-    const Watcher &watcher() const;
 
     bool hasExpireCallback() const;
     void addExpireCallback(ExpireCallback expireCallback);
@@ -55,11 +51,13 @@ public:
 private:
     EventLoop *loop_;
     State state_ = State::kClosed;
-    int fd_;
-    std::unique_ptr<Watcher> watcher_;
-    std::vector<ExpireCallback> expireCallbacks_;
+    TimerQueue::TimerId timerId_ = 0;
+    TimerQueue::Clock::time_point expiry_;
+    std::chrono::nanoseconds interval_{};
+    CallbackList<bool ()> expireCallbacks_;
 
-    bool onWatcherReadReady();
+    void schedule(TimerQueue::Clock::time_point expiry);
+    void onExpire();
 };
 
 } // namespace mq
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace mq {
+
+class TimerQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::move_only_function<void ()>;
+    using TimerId = uint64_t;
+
+    TimerQueue() = default;
+
+    TimerQueue(const TimerQueue &) = delete;
+    TimerQueue(TimerQueue &&) = delete;
+
+    TimerQueue &operator=(const TimerQueue &) = delete;
+    TimerQueue &operator=(TimerQueue &&) = delete;
+
+    bool empty() const {
+        return heap_.empty();
+    }
+
+    size_t size() const {
+        return heap_.size();
+    }
+
+    Clock::time_point nextExpiry() const;
+    bool contains(TimerId id) const;
+    TimerId add(Clock::time_point expiry, Callback callback);
+    bool cancel(TimerId id);
+    Callback pop();
+
+private:
+    struct Node {
+        Clock::time_point expiry;
+        uint64_t sequence;
+        uint32_t slot;
+    };
+
+    struct Slot {
+        Callback callback;
+        size_t index;
+        uint32_t generation = 1;
+    };
+
+    std::vector<Node> heap_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    uint64_t nextSequence_ = 0;
+
+    static bool less(const Node &lhs, const Node &rhs) {
+        return lhs.expiry < rhs.expiry || (lhs.expiry == rhs.expiry && lhs.sequence < rhs.sequence);
+    }
+
+    void place(size_t i, Node node);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    Callback removeAt(size_t i);
+};
+
+} // namespace mq
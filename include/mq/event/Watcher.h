@@ -3,7 +3,9 @@
 #pragma once
 
 #include <functional>
-#include <vector>
+#include <string>
+
+#include "mq/utils/CallbackList.h"
 
 namespace mq {
 
@@ -13,6 +15,8 @@ class Watcher {
 public:
     using ReadReadyCallback = std::move_only_function<bool ()>;
     using WriteReadyCallback = std::move_only_function<bool ()>;
+    using FlushCallback = std::move_only_function<bool ()>;
+    using ErrorCallback = std::move_only_function<bool ()>;
 
     explicit Watcher(EventLoop *loop, int fd);
     ~Watcher();
@@ -31,17 +35,42 @@ public:
         return fd_;
     }
 
+    const std::string &tag() const {
+        return tag_;
+    }
+
+    void setTag(std::string tag);
+
+    bool edgeTriggered() const {
+        return edgeTriggered_;
+    }
+
+    void setEdgeTriggered(bool edgeTriggered);
+
     bool hasReadReadyCallback() const;
     bool hasWriteReadyCallback() const;
+    bool hasFlushCallback() const;
+    bool hasErrorCallback() const;
 
     void addReadReadyCallback(ReadReadyCallback readReadyCallback);
     void addWriteReadyCallback(WriteReadyCallback writeReadyCallback);
+    void addFlushCallback(FlushCallback flushCallback);
+    void addErrorCallback(ErrorCallback errorCallback);
 
     void clearReadReadyCallbacks();
     void clearWriteReadyCallbacks();
+    void clearFlushCallbacks();
+    void clearErrorCallbacks();
 
     void dispatchReadReady();
     void dispatchWriteReady();
+    void dispatchFlush();
+    void dispatchError();
+
+    void clearReadReady();
+    void clearWriteReady();
+
+    void scheduleFlush();
 
     void registerSelf();
     void unregisterSelf();
@@ -49,8 +78,12 @@ public:
 private:
     EventLoop *loop_;
     int fd_;
-    std::vector<ReadReadyCallback> readReadyCallbacks_;
-    std::vector<WriteReadyCallback> writeReadyCallbacks_;
+    std::string tag_;
+    bool edgeTriggered_ = false;
+    CallbackList<bool ()> readReadyCallbacks_;
+    CallbackList<bool ()> writeReadyCallbacks_;
+    CallbackList<bool ()> flushCallbacks_;
+    CallbackList<bool ()> errorCallbacks_;
 
     friend class EventLoop;
 };
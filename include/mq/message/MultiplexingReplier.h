@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/message/Replier.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/Socket.h"
@@ -110,6 +111,38 @@ public:
         replier_.setKeepAlive(keepAlive);
     }
 
+    void setZeroCopyThreshold(size_t zeroCopyThreshold) {
+        replier_.setZeroCopyThreshold(zeroCopyThreshold);
+    }
+
+    void setWriteCoalescing(bool writeCoalescing) {
+        replier_.setWriteCoalescing(writeCoalescing);
+    }
+
+    void setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+        replier_.setWriteCoalescingDelay(writeCoalescingDelay);
+    }
+
+    void setWorkerGroup(EventLoopGroup *workerGroup) {
+        replier_.setWorkerGroup(workerGroup);
+    }
+
+    void setSharded(bool sharded) {
+        replier_.setSharded(sharded);
+    }
+
+    void setCpuSteering(bool cpuSteering) {
+        replier_.setCpuSteering(cpuSteering);
+    }
+
+    void setMaxInFlightMessages(size_t maxInFlightMessages) {
+        replier_.setMaxInFlightMessages(maxInFlightMessages);
+    }
+
+    void setMaxInFlightBytes(size_t maxInFlightBytes) {
+        replier_.setMaxInFlightBytes(maxInFlightBytes);
+    }
+
     void setRecvCallback(RecvCallback recvCallback);
     void setRecvCallbackExecutor(Executor *recvCallbackExecutor);
 
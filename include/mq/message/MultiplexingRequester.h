@@ -86,6 +86,14 @@ public:
         requester_.setKeepAlive(keepAlive);
     }
 
+    void setHighWatermark(size_t highWatermark) {
+        requester_.setHighWatermark(highWatermark);
+    }
+
+    void setLowWatermark(size_t lowWatermark) {
+        requester_.setLowWatermark(lowWatermark);
+    }
+
     void setConnectCallback(ConnectCallback connectCallback) {
         requester_.setConnectCallback(std::move(connectCallback));
     }
@@ -100,6 +108,14 @@ public:
         return requester_.waitForConnected(timeout);
     }
 
+    bool writable() const {
+        return requester_.writable();
+    }
+
+    int waitForWritable(std::chrono::nanoseconds timeout = {}) {
+        return requester_.waitForWritable(timeout);
+    }
+
     void send(MaybeOwnedString message,
               RecvCallback recvCallback,
               Executor *recvCallbackExecutor = nullptr);
@@ -4,19 +4,30 @@
 
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <format>
+#include <future>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
+#include "mq/message/TopicMatcher.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingAcceptor.h"
 #include "mq/net/FramingSocket.h"
 #include "mq/net/Socket.h"
+#include "mq/utils/LinkedHashMap.h"
 #include "mq/utils/MaybeOwnedString.h"
 #include "mq/utils/PtrEqual.h"
 #include "mq/utils/PtrHash.h"
+#include "mq/utils/SharedBuffer.h"
 
 namespace mq {
 
@@ -27,6 +38,23 @@ public:
         kOpened,
     };
 
+    enum class SlowSubscriberPolicy {
+        kNone,
+        kDropNewest,
+        kDropOldest,
+        kConflate,
+        kDisconnect,
+    };
+
+    struct SubscriberStats {
+        std::unique_ptr<Endpoint> remoteEndpoint;
+        size_t queuedMessages = 0;
+        size_t queuedBytes = 0;
+        uint64_t droppedMessages = 0;
+        uint64_t conflatedMessages = 0;
+        std::chrono::nanoseconds lag{};
+    };
+
     Publisher(EventLoop *loop, const Endpoint &localEndpoint);
     ~Publisher();
 
@@ -55,11 +83,27 @@ public:
     void setReusePort(bool reusePort);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setHighWatermark(size_t highWatermark);
+    void setLowWatermark(size_t lowWatermark);
+    void setSlowSubscriberPolicy(SlowSubscriberPolicy slowSubscriberPolicy);
+    void setMaxQueuedMessages(size_t maxQueuedMessages);
+    void setMaxQueuedBytes(size_t maxQueuedBytes);
+    void setMaxLag(std::chrono::nanoseconds maxLag);
+    void setLastValueCacheCapacity(size_t lastValueCacheCapacity);
+    void setSequenced(bool sequenced);
+    void setMaxSequencedTopics(size_t maxSequencedTopics);
+    void setWorkerGroup(EventLoopGroup *workerGroup);
+    void setSharded(bool sharded);
+    void setCpuSteering(bool cpuSteering);
 
     State state() const;
     int open();
+    bool writable() const;
+    int waitForWritable(std::chrono::nanoseconds timeout = {});
     void send(MaybeOwnedString message);
     void send(std::vector<MaybeOwnedString> pieces);
+    void send(std::string_view topic, MaybeOwnedString message);
+    std::vector<SubscriberStats> subscriberStats() const;
     void close();
 
 private:
@@ -67,6 +111,56 @@ private:
                                          PtrHash<std::shared_ptr<FramingSocket>>,
                                          PtrEqual<std::shared_ptr<FramingSocket>>>;
 
+    using SocketToTopicsMap = std::unordered_map<FramingSocket *, std::vector<std::string>>;
+
+    struct QueuedFrame {
+        SharedBuffer frame;
+        SharedBuffer topic;
+    };
+
+    struct Backlog {
+        std::deque<QueuedFrame> frames;
+        std::unordered_map<std::string_view, uint64_t> topicToId;
+        uint64_t firstId = 0;
+        size_t bytes = 0;
+        std::chrono::steady_clock::time_point behindSince;
+        uint64_t droppedMessages = 0;
+        uint64_t conflatedMessages = 0;
+        bool draining = false;
+        bool disconnecting = false;
+    };
+
+    using SocketToBacklogMap = std::unordered_map<FramingSocket *, Backlog>;
+
+    using SocketToHeldFramesMap = std::unordered_map<FramingSocket *, std::vector<QueuedFrame>>;
+
+    using LastValueCache = LinkedHashMap<std::string_view, QueuedFrame>;
+
+    struct TopicSequence {
+        SharedBuffer topic;
+        uint64_t sequence;
+    };
+
+    using TopicToSequenceMap = LinkedHashMap<std::string_view, TopicSequence>;
+
+    struct Shard {
+        EventLoop *loop;
+        size_t maxConnections;
+        SocketSet sockets;
+        std::unordered_set<FramingSocket *> unfilteredSockets;
+        SocketToTopicsMap socketToTopics;
+        SocketToBacklogMap backlogs;
+        SocketToHeldFramesMap snapshotPending;
+        LastValueCache lastValueCache;
+        size_t lastValueCacheSize = 0;
+        TopicMatcher<FramingSocket *> topicMatcher;
+        std::vector<FramingSocket *> matchedSockets;
+        std::shared_ptr<void> token;
+
+        Shard(EventLoop *loop, size_t maxConnections)
+            : loop(loop), maxConnections(maxConnections) {}
+    };
+
     EventLoop *loop_;
     std::unique_ptr<Endpoint> localEndpoint_;
     size_t maxConnections_ = 512;
@@ -80,13 +174,48 @@ private:
     bool reusePort_ = true;
     bool noDelay_ = true;
     KeepAlive keepAlive_{std::chrono::seconds(120), std::chrono::seconds(20), 3};
+    size_t highWatermark_ = 0;
+    size_t lowWatermark_ = 0;
+    SlowSubscriberPolicy slowSubscriberPolicy_ = SlowSubscriberPolicy::kNone;
+    size_t maxQueuedMessages_ = 0;
+    size_t maxQueuedBytes_ = 1024 * 1024;
+    std::chrono::nanoseconds maxLag_{};
+    size_t lastValueCacheCapacity_ = 0;
+    bool sequenced_ = false;
+    size_t maxSequencedTopics_ = 65536;
+    EventLoopGroup *workerGroup_ = nullptr;
+    bool sharded_ = false;
+    bool cpuSteering_ = false;
     State state_ = State::kClosed;
     std::unique_ptr<FramingAcceptor> acceptor_;
-    SocketSet sockets_;
+    std::vector<std::shared_ptr<Shard>> shards_;
+    size_t numBlockedSockets_ = 0;
+    std::optional<std::promise<void>> writablePromise_;
+    std::shared_future<void> writableFuture_;
+    TopicToSequenceMap topicToSequence_;
     std::shared_ptr<void> token_;
 
-    bool onFramingAcceptorAccept(std::unique_ptr<FramingSocket> socket);
-    bool onFramingSocketClose(FramingSocket *socket);
+    void sendFrame(SharedBuffer frame, SharedBuffer topic = {});
+    void sendShard(Shard *shard, const SharedBuffer &frame, const SharedBuffer &topic);
+    void sendSocket(Shard *shard, FramingSocket *socket, const SharedBuffer &frame, const SharedBuffer &topic);
+    void enqueueFrame(Shard *shard, FramingSocket *socket, Backlog &backlog, const SharedBuffer &frame, const SharedBuffer &topic);
+    void disconnect(Shard *shard, FramingSocket *socket, Backlog &backlog);
+    static void popFrame(Backlog &backlog);
+    uint64_t nextSequence(const SharedBuffer &topic);
+    void cacheFrame(Shard *shard, const SharedBuffer &frame, const SharedBuffer &topic);
+    void sendSnapshot(Shard *shard, FramingSocket *socket);
+    std::string_view frameMessage(const SharedBuffer &frame) const;
+    static void closeShard(Shard *shard);
+    void adjustBlockedSockets(int delta);
+    void releaseWritableWaiters();
+    static void addSubscription(Shard *shard, FramingSocket *socket, std::vector<std::string> topics);
+    static void removeSubscription(Shard *shard, FramingSocket *socket);
+    bool onFramingAcceptorAccept(Shard *shard, std::unique_ptr<FramingSocket> socket);
+    bool onFramingSocketRecv(Shard *shard, FramingSocket *socket, std::string_view message);
+    bool onFramingSocketSendComplete(Shard *shard, FramingSocket *socket);
+    bool onFramingSocketHighWatermark();
+    bool onFramingSocketDrained();
+    bool onFramingSocketClose(Shard *shard, FramingSocket *socket);
 };
 
 } // namespace mq
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingAcceptor.h"
 #include "mq/net/FramingSocket.h"
@@ -24,6 +25,8 @@
 namespace mq {
 
 class Replier {
+    struct Shard;
+
 public:
     enum class State {
         kClosed,
@@ -42,12 +45,12 @@ public:
         void operator()(std::vector<MaybeOwnedString> replyPieces);
 
     private:
-        Replier *replier_;
+        std::shared_ptr<Shard> shard_;
         std::shared_ptr<FramingSocket> socket_;
         std::weak_ptr<void> token_;
 
-        Promise(Replier *replier, std::shared_ptr<FramingSocket> socket, std::weak_ptr<void> token)
-            : replier_(replier), socket_(std::move(socket)), token_(std::move(token)) {}
+        Promise(std::shared_ptr<Shard> shard, std::shared_ptr<FramingSocket> socket, std::weak_ptr<void> token)
+            : shard_(std::move(shard)), socket_(std::move(socket)), token_(std::move(token)) {}
 
         friend class Replier;
     };
@@ -83,6 +86,14 @@ public:
     void setReusePort(bool reusePort);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setZeroCopyThreshold(size_t zeroCopyThreshold);
+    void setWriteCoalescing(bool writeCoalescing);
+    void setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay);
+    void setWorkerGroup(EventLoopGroup *workerGroup);
+    void setSharded(bool sharded);
+    void setCpuSteering(bool cpuSteering);
+    void setMaxInFlightMessages(size_t maxInFlightMessages);
+    void setMaxInFlightBytes(size_t maxInFlightBytes);
 
     void setRecvCallback(RecvCallback recvCallback);
     void setRecvCallbackExecutor(Executor *recvCallbackExecutor);
@@ -97,6 +108,19 @@ private:
                                          PtrHash<std::shared_ptr<FramingSocket>>,
                                          PtrEqual<std::shared_ptr<FramingSocket>>>;
 
+    struct Shard : std::enable_shared_from_this<Shard> {
+        EventLoop *loop;
+        size_t maxConnections;
+        SocketSet sockets;
+        size_t inFlightMessages = 0;
+        size_t inFlightBytes = 0;
+        bool recvPaused = false;
+        std::shared_ptr<void> token;
+
+        Shard(EventLoop *loop, size_t maxConnections)
+            : loop(loop), maxConnections(maxConnections) {}
+    };
+
     EventLoop *loop_;
     std::unique_ptr<Endpoint> localEndpoint_;
     size_t maxConnections_ = 512;
@@ -110,16 +134,26 @@ private:
     bool reusePort_ = true;
     bool noDelay_ = true;
     KeepAlive keepAlive_{std::chrono::seconds(120), std::chrono::seconds(20), 3};
+    size_t zeroCopyThreshold_ = 0;
+    bool writeCoalescing_ = false;
+    std::chrono::nanoseconds writeCoalescingDelay_{};
+    EventLoopGroup *workerGroup_ = nullptr;
+    bool sharded_ = false;
+    bool cpuSteering_ = false;
+    size_t maxInFlightMessages_ = 0;
+    size_t maxInFlightBytes_ = 0;
     RecvCallback recvCallback_;
     Executor *recvCallbackExecutor_ = nullptr;
     State state_ = State::kClosed;
     std::unique_ptr<FramingAcceptor> acceptor_;
-    SocketSet sockets_;
-    std::shared_ptr<void> token_;
-
-    bool onFramingAcceptorAccept(std::unique_ptr<FramingSocket> socket);
-    bool onFramingSocketRecv(FramingSocket *socket, std::string_view message);
-    bool onFramingSocketClose(FramingSocket *socket);
+    std::vector<std::shared_ptr<Shard>> shards_;
+
+    static void closeShard(Shard *shard);
+    bool onFramingAcceptorAccept(Shard *shard, std::unique_ptr<FramingSocket> socket);
+    bool onFramingSocketRecv(Shard *shard, FramingSocket *socket, std::string_view message);
+    bool onFramingSocketClose(Shard *shard, FramingSocket *socket);
+    void acquireInFlight(Shard *shard, FramingSocket *socket, size_t size);
+    void releaseInFlight(Shard *shard, size_t size);
 };
 
 } // namespace mq
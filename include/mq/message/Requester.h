@@ -6,7 +6,9 @@
 #include <cstddef>
 #include <format>
 #include <functional>
+#include <future>
 #include <memory>
+#include <optional>
 #include <string_view>
 #include <vector>
 
@@ -55,6 +57,10 @@ public:
     void setSendTimeout(std::chrono::nanoseconds sendTimeout);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setHighWatermark(size_t highWatermark);
+    void setLowWatermark(size_t lowWatermark);
+    void setMaxInFlightMessages(size_t maxInFlightMessages);
+    void setMaxInFlightBytes(size_t maxInFlightBytes);
 
     void setConnectCallback(ConnectCallback connectCallback);
     void setRecvCallback(RecvCallback recvCallback);
@@ -68,6 +74,8 @@ public:
     State state() const;
     void open();
     int waitForConnected(std::chrono::nanoseconds timeout = {});
+    bool writable() const;
+    int waitForWritable(std::chrono::nanoseconds timeout = {});
     void send(MaybeOwnedString message);
     void send(std::vector<MaybeOwnedString> pieces);
     void close();
@@ -84,16 +92,28 @@ private:
     std::chrono::nanoseconds sendTimeout_{};
     bool noDelay_ = true;
     KeepAlive keepAlive_{};
+    size_t highWatermark_ = 0;
+    size_t lowWatermark_ = 0;
+    size_t maxInFlightMessages_ = 0;
+    size_t maxInFlightBytes_ = 0;
     ConnectCallback connectCallback_;
     RecvCallback recvCallback_;
     Executor *connectCallbackExecutor_ = nullptr;
     Executor *recvCallbackExecutor_ = nullptr;
     State state_ = State::kClosed;
     std::unique_ptr<FramingSocket> socket_;
+    size_t inFlightMessages_ = 0;
+    size_t inFlightBytes_ = 0;
+    bool recvPaused_ = false;
+    std::optional<std::promise<void>> writablePromise_;
+    std::shared_future<void> writableFuture_;
     std::shared_ptr<void> token_;
 
     bool onFramingSocketConnect(int error);
     bool onFramingSocketRecv(std::string_view message);
+    void acquireInFlight(size_t size);
+    void releaseInFlight(size_t size);
+    void releaseWritableWaiters();
 };
 
 } // namespace mq
@@ -4,6 +4,7 @@
 
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <format>
 #include <memory>
 #include <string>
@@ -13,14 +14,17 @@
 #include <vector>
 
 #include "mq/event/EventLoop.h"
+#include "mq/message/TopicMatcher.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingSocket.h"
 #include "mq/net/Socket.h"
 #include "mq/utils/Executor.h"
 #include "mq/utils/IndirectEqual.h"
 #include "mq/utils/IndirectHash.h"
+#include "mq/utils/LinkedHashMap.h"
 #include "mq/utils/PtrEqual.h"
 #include "mq/utils/PtrHash.h"
+#include "mq/utils/SharedBuffer.h"
 
 namespace mq {
 
@@ -32,6 +36,10 @@ public:
     };
 
     using RecvCallback = std::move_only_function<void (const Endpoint &remoteEndpoint, std::string_view message)>;
+    using GapCallback = std::move_only_function<void (const Endpoint &remoteEndpoint,
+                                                      std::string_view topic,
+                                                      uint64_t expectedSequence,
+                                                      uint64_t sequence)>;
 
     explicit Subscriber(EventLoop *loop);
     ~Subscriber();
@@ -55,14 +63,22 @@ public:
     void setSendTimeout(std::chrono::nanoseconds sendTimeout);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setMaxInFlightMessages(size_t maxInFlightMessages);
+    void setMaxInFlightBytes(size_t maxInFlightBytes);
+    void setSequenced(bool sequenced);
+    void setMaxSequencedTopics(size_t maxSequencedTopics);
 
     void setRecvCallback(RecvCallback recvCallback);
     void setRecvCallbackExecutor(Executor *recvCallbackExecutor);
     void dispatchRecv(const Endpoint &remoteEndpoint, std::string_view message);
 
+    void setGapCallback(GapCallback gapCallback);
+    void dispatchGap(const Endpoint &remoteEndpoint, std::string_view topic, uint64_t expectedSequence, uint64_t sequence);
+
     State state() const;
     void subscribe(const Endpoint &remoteEndpoint, std::vector<std::string> topics);
     void unsubscribe(const Endpoint &remoteEndpoint);
+    void setTopics(const Endpoint &remoteEndpoint, std::vector<std::string> topics);
 
 private:
     using SocketSet = std::unordered_set<std::shared_ptr<FramingSocket>,
@@ -74,7 +90,21 @@ private:
                                                    IndirectHash<std::unique_ptr<Endpoint>>,
                                                    IndirectEqual<std::unique_ptr<Endpoint>>>;
 
-    using SocketToTopicsMap = std::unordered_map<FramingSocket *, std::vector<std::string>>;
+    struct SocketTopics {
+        std::vector<std::string> topics;
+        TopicMatcher<bool> topicMatcher;
+    };
+
+    using SocketToTopicsMap = std::unordered_map<FramingSocket *, SocketTopics>;
+
+    struct TopicSequence {
+        SharedBuffer topic;
+        uint64_t sequence;
+    };
+
+    using TopicToSequenceMap = LinkedHashMap<std::string_view, TopicSequence>;
+
+    using SocketToSequencesMap = std::unordered_map<FramingSocket *, TopicToSequenceMap>;
 
     EventLoop *loop_;
     std::chrono::nanoseconds reconnectInterval_ = std::chrono::milliseconds(100);
@@ -86,15 +116,29 @@ private:
     std::chrono::nanoseconds sendTimeout_{};
     bool noDelay_ = true;
     KeepAlive keepAlive_{};
+    size_t maxInFlightMessages_ = 0;
+    size_t maxInFlightBytes_ = 0;
+    bool sequenced_ = false;
+    size_t maxSequencedTopics_ = 65536;
     RecvCallback recvCallback_;
     Executor *recvCallbackExecutor_ = nullptr;
+    GapCallback gapCallback_;
     State state_ = State::kClosed;
     SocketSet sockets_;
     EndpointToSocketMap endpointToSocket_;
     SocketToTopicsMap socketToTopics_;
+    SocketToSequencesMap socketToSequences_;
+    size_t inFlightMessages_ = 0;
+    size_t inFlightBytes_ = 0;
+    bool recvPaused_ = false;
     std::shared_ptr<void> token_;
 
+    void sendSubscription(FramingSocket *socket);
+    bool onFramingSocketConnect(FramingSocket *socket, int error);
     bool onFramingSocketRecv(FramingSocket *socket, std::string_view message);
+    void checkSequence(FramingSocket *socket, std::string_view topic, uint64_t sequence);
+    void acquireInFlight(FramingSocket *socket, size_t size);
+    void releaseInFlight(size_t size);
 };
 
 } // namespace mq
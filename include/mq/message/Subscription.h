@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mq {
+
+std::string encodeSubscription(std::span<const std::string> topics);
+bool decodeSubscription(std::string_view message, std::vector<std::string> &topics);
+
+// A sequence header is a sequence number (0 if unsequenced) followed by the length of the topic, and
+// precedes the topic and the message.
+inline constexpr size_t kSequenceHeaderSize = 10;
+
+void encodeSequenceHeader(char *header, uint64_t sequence, size_t topicLength);
+void setSequence(char *header, uint64_t sequence);
+bool decodeSequenceHeader(std::string_view &message, uint64_t &sequence, std::string_view &topic);
+
+} // namespace mq
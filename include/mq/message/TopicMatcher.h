@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mq {
+
+// Matches messages against topics. A topic matches every message that starts with it, where a segment
+// (delimited by '.') consisting of "*" matches exactly one segment and "#" matches zero or more segments.
+template <typename T>
+class TopicMatcher {
+public:
+    TopicMatcher()
+        : root_(std::make_unique<Node>()) {}
+
+    TopicMatcher(const TopicMatcher &) = delete;
+    TopicMatcher(TopicMatcher &&) = default;
+
+    TopicMatcher &operator=(const TopicMatcher &) = delete;
+    TopicMatcher &operator=(TopicMatcher &&) = default;
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    void add(std::string_view topic, T value) {
+        Node *node = root_.get();
+
+        for (size_t i = 0; i < topic.size();) {
+            if (isWildcard(topic, i)) {
+                std::unique_ptr<Node> &child = topic[i] == '*' ? node->star : node->hash;
+
+                if (!child) {
+                    child = std::make_unique<Node>();
+                }
+
+                node = child.get();
+                ++i;
+            } else {
+                size_t j = literalEnd(topic, i);
+                node = addLiteral(node, topic.substr(i, j - i));
+                i = j;
+            }
+        }
+
+        node->values.emplace_back(std::move(value));
+        ++size_;
+    }
+
+    bool remove(std::string_view topic, const T &value) {
+        if (!remove(root_.get(), topic, 0, value)) return false;
+
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        root_ = std::make_unique<Node>();
+        size_ = 0;
+    }
+
+    // Calls f(value) for the value of each matching topic until f returns false. A value may be reported
+    // more than once if several of its topics match, or if a "#" topic matches in more than one way.
+    template <typename F>
+    void match(std::string_view message, F &&f) const {
+        match(root_.get(), 0, message, 0, f);
+    }
+
+    bool matches(std::string_view message) const {
+        bool matched = false;
+
+        match(message, [&matched](const T &) {
+            matched = true;
+            return false;
+        });
+
+        return matched;
+    }
+
+private:
+    struct Node {
+        std::string label;
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> star;
+        std::unique_ptr<Node> hash;
+        std::vector<T> values;
+    };
+
+    using ChildIterator = typename std::vector<std::unique_ptr<Node>>::iterator;
+
+    std::unique_ptr<Node> root_;
+    size_t size_ = 0;
+
+    static bool isWildcard(std::string_view topic, size_t i) {
+        return (topic[i] == '*' || topic[i] == '#') &&
+               (i == 0 || topic[i - 1] == '.') &&
+               (i + 1 == topic.size() || topic[i + 1] == '.');
+    }
+
+    static size_t literalEnd(std::string_view topic, size_t i) {
+        while (i < topic.size() && !isWildcard(topic, i)) ++i;
+
+        return i;
+    }
+
+    static bool isEmpty(const Node &node) {
+        return node.values.empty() && node.children.empty() && !node.star && !node.hash;
+    }
+
+    static ChildIterator lowerBound(Node *node, char c) {
+        return std::lower_bound(node->children.begin(), node->children.end(), c,
+                                [](const std::unique_ptr<Node> &child, char c) { return child->label[0] < c; });
+    }
+
+    static const Node *findChild(const Node *node, char c) {
+        ChildIterator i = lowerBound(const_cast<Node *>(node), c);
+
+        if (i == node->children.end() || (*i)->label[0] != c) return nullptr;
+
+        return i->get();
+    }
+
+    static Node *addLiteral(Node *node, std::string_view literal) {
+        while (!literal.empty()) {
+            ChildIterator i = lowerBound(node, literal[0]);
+
+            if (i == node->children.end() || (*i)->label[0] != literal[0]) {
+                std::unique_ptr<Node> child = std::make_unique<Node>();
+                child->label = literal;
+                return node->children.insert(i, std::move(child))->get();
+            }
+
+            std::string &label = (*i)->label;
+            size_t n = std::mismatch(label.begin(), label.end(), literal.begin(), literal.end()).first - label.begin();
+
+            if (n < label.size()) {
+                std::unique_ptr<Node> parent = std::make_unique<Node>();
+                parent->label = label.substr(0, n);
+                label.erase(0, n);
+                parent->children.emplace_back(std::move(*i));
+                *i = std::move(parent);
+            }
+
+            node = i->get();
+            literal.remove_prefix(n);
+        }
+
+        return node;
+    }
+
+    static void compact(Node *node) {
+        if (!node->values.empty() || node->children.size() != 1 || node->star || node->hash) return;
+
+        std::unique_ptr<Node> child = std::move(node->children.front());
+
+        node->label += child->label;
+        node->children = std::move(child->children);
+        node->star = std::move(child->star);
+        node->hash = std::move(child->hash);
+        node->values = std::move(child->values);
+    }
+
+    static bool remove(Node *node, std::string_view topic, size_t i, const T &value) {
+        if (i == topic.size()) {
+            auto j = std::find(node->values.begin(), node->values.end(), value);
+
+            if (j == node->values.end()) return false;
+
+            node->values.erase(j);
+            return true;
+        }
+
+        if (isWildcard(topic, i)) {
+            std::unique_ptr<Node> &child = topic[i] == '*' ? node->star : node->hash;
+
+            if (!child || !remove(child.get(), topic, i + 1, value)) return false;
+
+            if (isEmpty(*child)) {
+                child = nullptr;
+            }
+
+            return true;
+        }
+
+        ChildIterator j = lowerBound(node, topic[i]);
+
+        if (j == node->children.end() || (*j)->label[0] != topic[i]) return false;
+
+        Node *child = j->get();
+        std::string_view label = child->label;
+
+        if (literalEnd(topic, i) - i < label.size() || topic.substr(i, label.size()) != label) return false;
+
+        if (!remove(child, topic, i + label.size(), value)) return false;
+
+        if (isEmpty(*child)) {
+            node->children.erase(j);
+        } else {
+            compact(child);
+        }
+
+        return true;
+    }
+
+    template <typename F>
+    static bool match(const Node *node, size_t skip, std::string_view message, size_t pos, F &f) {
+        std::string_view label = std::string_view(node->label).substr(skip);
+
+        if (message.size() - pos < label.size() || message.substr(pos, label.size()) != label) return true;
+
+        pos += label.size();
+
+        for (const T &value : node->values) {
+            if (!f(value)) return false;
+        }
+
+        if (pos < message.size()) {
+            if (const Node *child = findChild(node, message[pos])) {
+                if (!match(child, 0, message, pos, f)) return false;
+            }
+        }
+
+        if (node->star && pos < message.size() && message[pos] != '.') {
+            size_t end = std::min(message.find('.', pos), message.size());
+
+            if (!match(node->star.get(), 0, message, end, f)) return false;
+        }
+
+        if (node->hash) {
+            const Node *hash = node->hash.get();
+
+            for (const T &value : hash->values) {
+                if (!f(value)) return false;
+            }
+
+            if (const Node *child = findChild(hash, '.')) {
+                if (pos == 0) {
+                    if (!match(child, 1, message, 0, f)) return false;
+                } else {
+                    if (!match(child, 0, message, pos - 1, f)) return false;
+                }
+
+                for (size_t end = message.find('.', pos); end != std::string_view::npos; end = message.find('.', end + 1)) {
+                    if (!match(child, 0, message, end, f)) return false;
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+} // namespace mq
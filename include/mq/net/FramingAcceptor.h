@@ -9,6 +9,8 @@
 #include <memory>
 #include <vector>
 
+#include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/net/Acceptor.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingSocket.h"
@@ -25,6 +27,8 @@ public:
 
     using AcceptCallback =
         std::move_only_function<bool (std::unique_ptr<FramingSocket> socket, const Endpoint &remoteEndpoint)>;
+    using WorkerAcceptCallback =
+        std::move_only_function<void (std::unique_ptr<FramingSocket> socket, const Endpoint &remoteEndpoint)>;
 
     explicit FramingAcceptor(EventLoop *loop);
     ~FramingAcceptor();
@@ -43,12 +47,24 @@ public:
     void setRecvBufferMaxCapacity(size_t recvBufferMaxCapacity);
     void setSendBufferMaxCapacity(size_t sendBufferMaxCapacity);
     void setRecvChunkSize(size_t recvChunkSize);
+    void setRecvBudget(size_t recvBudget);
     void setRecvTimeout(std::chrono::nanoseconds recvTimeout);
     void setSendTimeout(std::chrono::nanoseconds sendTimeout);
     void setReuseAddr(bool reuseAddr);
     void setReusePort(bool reusePort);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setBusyPoll(std::chrono::microseconds busyPoll);
+    void setEdgeTriggered(bool edgeTriggered);
+    void setZeroCopyThreshold(size_t zeroCopyThreshold);
+    void setWriteCoalescing(bool writeCoalescing);
+    void setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay);
+    void setHighWatermark(size_t highWatermark);
+    void setLowWatermark(size_t lowWatermark);
+    void setWorkerGroup(EventLoopGroup *workerGroup);
+    void setWorkerAcceptCallback(WorkerAcceptCallback workerAcceptCallback);
+    void setSharded(bool sharded);
+    void setCpuSteering(bool cpuSteering);
 
     State state();
     Acceptor &acceptor();
@@ -70,12 +86,24 @@ private:
     size_t recvBufferMaxCapacity_ = 16 * 1024 * 1024;
     size_t sendBufferMaxCapacity_ = 16 * 1024 * 1024;
     size_t recvChunkSize_ = 4096;
+    size_t recvBudget_ = 65536;
     std::chrono::nanoseconds recvTimeout_{};
     std::chrono::nanoseconds sendTimeout_{};
     bool reuseAddr_ = true;
     bool reusePort_ = true;
     bool noDelay_ = false;
     KeepAlive keepAlive_{};
+    std::chrono::microseconds busyPoll_{};
+    bool edgeTriggered_ = false;
+    size_t zeroCopyThreshold_ = 0;
+    bool writeCoalescing_ = false;
+    std::chrono::nanoseconds writeCoalescingDelay_{};
+    size_t highWatermark_ = 0;
+    size_t lowWatermark_ = 0;
+    EventLoopGroup *workerGroup_ = nullptr;
+    std::shared_ptr<WorkerAcceptCallback> workerAcceptCallback_;
+    bool sharded_ = false;
+    bool cpuSteering_ = false;
     State state_ = State::kClosed;
     std::unique_ptr<Acceptor> acceptor_;
     std::unique_ptr<Endpoint> localEndpoint_;
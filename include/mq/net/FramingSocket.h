@@ -7,12 +7,15 @@
 #include <format>
 #include <functional>
 #include <memory>
+#include <span>
 #include <string_view>
-#include <vector>
 
 #include "mq/event/EventLoop.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/Socket.h"
+#include "mq/utils/CallbackList.h"
+#include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SharedBuffer.h"
 
 namespace mq {
 
@@ -27,6 +30,8 @@ public:
     using ConnectCallback = std::move_only_function<bool (int error)>;
     using RecvCallback = std::move_only_function<bool (std::string_view message)>;
     using SendCompleteCallback = std::move_only_function<bool ()>;
+    using HighWatermarkCallback = std::move_only_function<bool ()>;
+    using DrainedCallback = std::move_only_function<bool ()>;
     using CloseCallback = std::move_only_function<bool (int error)>;
 
     explicit FramingSocket(EventLoop *loop);
@@ -46,65 +51,106 @@ public:
     void setRecvBufferMaxCapacity(size_t recvBufferMaxCapacity);
     void setSendBufferMaxCapacity(size_t sendBufferMaxCapacity);
     void setRecvChunkSize(size_t recvChunkSize);
+    void setRecvBudget(size_t recvBudget);
     void setRecvTimeout(std::chrono::nanoseconds recvTimeout);
     void setSendTimeout(std::chrono::nanoseconds sendTimeout);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setBusyPoll(std::chrono::microseconds busyPoll);
+    void setEdgeTriggered(bool edgeTriggered);
+    void setZeroCopyThreshold(size_t zeroCopyThreshold);
+    void setWriteCoalescing(bool writeCoalescing);
+    void setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay);
+    void setHighWatermark(size_t highWatermark);
+    void setLowWatermark(size_t lowWatermark);
 
     State state() const;
     Socket &socket();
     const Socket &socket() const;
     std::unique_ptr<Endpoint> localEndpoint() const;
     std::unique_ptr<Endpoint> remoteEndpoint() const;
+    bool writable() const;
 
     bool hasConnectCallback() const;
     bool hasRecvCallback() const;
     bool hasSendCompleteCallback() const;
+    bool hasHighWatermarkCallback() const;
+    bool hasDrainedCallback() const;
     bool hasCloseCallback() const;
 
     void addConnectCallback(ConnectCallback connectCallback);
     void addRecvCallback(RecvCallback recvCallback);
-    void addSendCompleteCallback(SendCompleteCallback sendCompleteCallback);
-    void addCloseCallback(CloseCallback closeCallback);
+    CallbackId addSendCompleteCallback(SendCompleteCallback sendCompleteCallback);
+    void addHighWatermarkCallback(HighWatermarkCallback highWatermarkCallback);
+    void addDrainedCallback(DrainedCallback drainedCallback);
+    CallbackId addCloseCallback(CloseCallback closeCallback);
+
+    void removeSendCompleteCallback(CallbackId id);
+    void removeCloseCallback(CallbackId id);
 
     void clearConnectCallbacks();
     void clearRecvCallbacks();
     void clearSendCompleteCallbacks();
+    void clearHighWatermarkCallbacks();
+    void clearDrainedCallbacks();
     void clearCloseCallbacks();
 
     void dispatchConnect(int error);
     void dispatchRecv(std::string_view message);
     void dispatchSendComplete();
+    void dispatchHighWatermark();
+    void dispatchDrained();
     void dispatchClose(int error);
 
     void open(const Endpoint &remoteEndpoint);
     void open(std::unique_ptr<Socket> socket, const Endpoint &remoteEndpoint);
-    int send(std::string_view message);
-    int send(const std::vector<std::string_view> &pieces);
+    int send(MaybeOwnedString message);
+    int send(std::span<const std::string_view> pieces);
+    int send(std::span<MaybeOwnedString> pieces);
+    int sendFrame(SharedBuffer frame);
+    int sendFrames(std::span<const SharedBuffer> frames);
+    void flush();
+    void pauseRecv();
+    void resumeRecv();
     void close(int error = 0);
     void reset();
 
+    static SharedBuffer frame(std::string_view message);
+    static SharedBuffer frame(std::span<const MaybeOwnedString> pieces);
+
 private:
     EventLoop *loop_;
     size_t maxMessageLength_ = 8 * 1024 * 1024;
     size_t recvBufferMaxCapacity_ = 16 * 1024 * 1024;
     size_t sendBufferMaxCapacity_ = 16 * 1024 * 1024;
     size_t recvChunkSize_ = 4096;
+    size_t recvBudget_ = 65536;
     std::chrono::nanoseconds recvTimeout_{};
     std::chrono::nanoseconds sendTimeout_{};
     bool noDelay_ = false;
     KeepAlive keepAlive_{};
+    std::chrono::microseconds busyPoll_{};
+    bool edgeTriggered_ = false;
+    size_t zeroCopyThreshold_ = 0;
+    bool writeCoalescing_ = false;
+    std::chrono::nanoseconds writeCoalescingDelay_{};
+    size_t highWatermark_ = 0;
+    size_t lowWatermark_ = 0;
     State state_ = State::kClosed;
     std::unique_ptr<Socket> socket_;
     std::unique_ptr<Endpoint> localEndpoint_;
     std::unique_ptr<Endpoint> remoteEndpoint_;
-    std::vector<ConnectCallback> connectCallbacks_;
-    std::vector<RecvCallback> recvCallbacks_;
-    std::vector<SendCompleteCallback> sendCompleteCallbacks_;
-    std::vector<CloseCallback> closeCallbacks_;
+    CallbackList<bool (int error)> connectCallbacks_;
+    CallbackList<bool (std::string_view message)> recvCallbacks_;
+    CallbackList<bool ()> sendCompleteCallbacks_;
+    CallbackList<bool ()> highWatermarkCallbacks_;
+    CallbackList<bool ()> drainedCallbacks_;
+    CallbackList<bool (int error)> closeCallbacks_;
 
     bool onSocketRecv(const char *data, size_t size, size_t &newSize);
     bool onSocketSendComplete();
+    bool onSocketHighWatermark();
+    bool onSocketDrained();
     bool onSocketClose(int error);
 };
 
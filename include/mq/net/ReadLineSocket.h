@@ -7,6 +7,7 @@
 #include <format>
 #include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -83,7 +84,7 @@ public:
     void open(const Endpoint &remoteEndpoint);
     void open(std::unique_ptr<Socket> socket, const Endpoint &remoteEndpoint);
     int send(const char *data, size_t size);
-    int send(const std::vector<std::pair<const char *, size_t>> &buffers);
+    int send(std::span<const std::pair<const char *, size_t>> buffers);
     void close(int error = 0);
     void reset();
 
@@ -4,15 +4,22 @@
 
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <vector>
+#include <span>
+#include <utility>
+
+#include <sys/uio.h>
 
 #include "mq/event/EventLoop.h"
 #include "mq/event/Timer.h"
 #include "mq/event/Watcher.h"
 #include "mq/net/Endpoint.h"
 #include "mq/utils/Buffer.h"
+#include "mq/utils/CallbackList.h"
+#include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SendQueue.h"
 
 namespace mq {
 
@@ -42,9 +49,24 @@ public:
         kConnected,
     };
 
+    struct Stats {
+        uint64_t recvCalls = 0;
+        uint64_t recvBytes = 0;
+        uint64_t sendCalls = 0;
+        uint64_t sendBytes = 0;
+        uint64_t zeroCopySends = 0;
+        uint64_t zeroCopyCompletions = 0;
+        uint64_t zeroCopyCopied = 0;
+        uint64_t coalescedSends = 0;
+        uint64_t flushes = 0;
+        size_t recvChunkSize = 0;
+    };
+
     using ConnectCallback = std::move_only_function<bool (int error)>;
     using RecvCallback = std::move_only_function<bool (const char *data, size_t size, size_t &newSize)>;
     using SendCompleteCallback = std::move_only_function<bool ()>;
+    using HighWatermarkCallback = std::move_only_function<bool ()>;
+    using DrainedCallback = std::move_only_function<bool ()>;
     using CloseCallback = std::move_only_function<bool (int error, const char *data, size_t size)>;
 
     explicit Socket(EventLoop *loop);
@@ -63,10 +85,18 @@ public:
     void setRecvBufferMaxCapacity(size_t recvBufferMaxCapacity);
     void setSendBufferMaxCapacity(size_t sendBufferMaxCapacity);
     void setRecvChunkSize(size_t recvChunkSize);
+    void setRecvBudget(size_t recvBudget);
     void setRecvTimeout(std::chrono::nanoseconds recvTimeout);
     void setSendTimeout(std::chrono::nanoseconds sendTimeout);
     void setNoDelay(bool noDelay);
     void setKeepAlive(KeepAlive keepAlive);
+    void setBusyPoll(std::chrono::microseconds busyPoll);
+    void setEdgeTriggered(bool edgeTriggered);
+    void setZeroCopyThreshold(size_t zeroCopyThreshold);
+    void setWriteCoalescing(bool writeCoalescing);
+    void setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay);
+    void setHighWatermark(size_t highWatermark);
+    void setLowWatermark(size_t lowWatermark);
 
     State state() const;
     int fd() const;
@@ -74,61 +104,110 @@ public:
     const Watcher &watcher() const;
     std::unique_ptr<Endpoint> localEndpoint() const;
     std::unique_ptr<Endpoint> remoteEndpoint() const;
+    int incomingCpu() const;
+    size_t sendBufferSize() const;
+    bool writable() const;
+    bool recvPaused() const;
+    Stats stats() const;
+    void resetStats();
 
     bool hasConnectCallback() const;
     bool hasRecvCallback() const;
     bool hasSendCompleteCallback() const;
+    bool hasHighWatermarkCallback() const;
+    bool hasDrainedCallback() const;
     bool hasCloseCallback() const;
 
     void addConnectCallback(ConnectCallback connectCallback);
     void addRecvCallback(RecvCallback recvCallback);
     void addSendCompleteCallback(SendCompleteCallback sendCompleteCallback);
+    void addHighWatermarkCallback(HighWatermarkCallback highWatermarkCallback);
+    void addDrainedCallback(DrainedCallback drainedCallback);
     void addCloseCallback(CloseCallback closeCallback);
 
     void clearConnectCallbacks();
     void clearRecvCallbacks();
     void clearSendCompleteCallbacks();
+    void clearHighWatermarkCallbacks();
+    void clearDrainedCallbacks();
     void clearCloseCallbacks();
 
     void dispatchConnect(int error);
     void dispatchRecv(const char *data, size_t size, size_t &newSize);
     void dispatchSendComplete();
+    void dispatchHighWatermark();
+    void dispatchDrained();
     void dispatchClose(int error, const char *data, size_t size);
 
     void open(const Endpoint &remoteEndpoint);
     void open(int fd, const Endpoint &remoteEndpoint);
     int send(const char *data, size_t size);
-    int send(const std::vector<std::pair<const char *, size_t>> &buffers);
+    int send(std::span<const std::pair<const char *, size_t>> buffers);
+    int send(std::span<MaybeOwnedString> pieces);
+    void flush();
+    void pauseRecv();
+    void resumeRecv();
     void close(int error = 0);
     void reset();
 
 private:
     EventLoop *loop_;
     size_t recvChunkSize_ = 4096;
+    size_t adaptiveRecvChunkSize_ = 4096;
+    int recvShrinkCount_ = 0;
+    size_t recvBudget_ = 65536;
     std::chrono::nanoseconds recvTimeout_{};
     std::chrono::nanoseconds sendTimeout_{};
     bool noDelay_ = false;
     KeepAlive keepAlive_{};
+    std::chrono::microseconds busyPoll_{};
+    bool edgeTriggered_ = false;
+    size_t zeroCopyThreshold_ = 0;
+    bool zeroCopy_ = false;
+    uint32_t zeroCopyId_ = 0;
+    bool writeCoalescing_ = false;
+    std::chrono::nanoseconds writeCoalescingDelay_{};
+    size_t highWatermark_ = 0;
+    size_t lowWatermark_ = 0;
     State state_ = State::kClosed;
     int fd_;
     std::unique_ptr<Watcher> watcher_;
     std::unique_ptr<Endpoint> localEndpoint_;
     std::unique_ptr<Endpoint> remoteEndpoint_;
     Buffer recvBuffer_;
-    Buffer sendBuffer_;
+    SendQueue sendQueue_;
     std::unique_ptr<Timer> recvTimer_;
     std::unique_ptr<Timer> sendTimer_;
+    std::unique_ptr<Timer> flushTimer_;
+    bool flushPending_ = false;
+    bool aboveHighWatermark_ = false;
     bool recvActive_ = false;
+    bool recvPaused_ = false;
     bool sendActive_ = false;
-    std::vector<ConnectCallback> connectCallbacks_;
-    std::vector<RecvCallback> recvCallbacks_;
-    std::vector<SendCompleteCallback> sendCompleteCallbacks_;
-    std::vector<CloseCallback> closeCallbacks_;
-
+    CallbackList<bool (int error)> connectCallbacks_;
+    CallbackList<bool (const char *data, size_t size, size_t &newSize)> recvCallbacks_;
+    CallbackList<bool ()> sendCompleteCallbacks_;
+    CallbackList<bool ()> highWatermarkCallbacks_;
+    CallbackList<bool ()> drainedCallbacks_;
+    CallbackList<bool (int error, const char *data, size_t size)> closeCallbacks_;
+    Stats stats_;
+
+    bool sendDirect(iovec *iovs, size_t numIovecs, size_t &sentSize);
+    bool flushSendQueue();
+    bool drainErrorQueue();
+    void scheduleFlush();
+    void checkHighWatermark();
+    bool checkLowWatermark();
+    void recordRecv(size_t size);
+    void recordSend(size_t size);
+    void adaptRecvChunkSize(size_t chunkSize, size_t size);
     bool onWatcherReadReady();
     bool onWatcherWriteReady();
+    bool onWatcherFlush();
+    bool onWatcherError();
     bool onRecvTimerExpire();
     bool onSendTimerExpire();
+    bool onFlushTimerExpire();
 };
 
 } // namespace mq
@@ -3,9 +3,12 @@
 #pragma once
 
 #include <chrono>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
 #include <future>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -26,6 +29,30 @@ public:
         kOpened = static_cast<int>(MultiplexingRequester::State::kOpened),
     };
 
+    class CallAwaiter {
+    public:
+        CallAwaiter(RpcClient *client, MaybeOwnedString methodName, std::vector<MaybeOwnedString> pieces);
+
+        CallAwaiter(const CallAwaiter &) = delete;
+        CallAwaiter(CallAwaiter &&) = delete;
+
+        CallAwaiter &operator=(const CallAwaiter &) = delete;
+        CallAwaiter &operator=(CallAwaiter &&) = delete;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle);
+        Expected<std::string, RpcError> await_resume();
+
+    private:
+        RpcClient *client_;
+        uint8_t methodNameLength_;
+        std::vector<MaybeOwnedString> pieces_;
+        std::optional<Expected<std::string, RpcError>> result_;
+    };
+
     RpcClient(const RpcClient &) = delete;
     RpcClient(RpcClient &&) = delete;
 
@@ -105,6 +132,9 @@ public:
     std::future<Expected<std::string, RpcError>> call(
         MaybeOwnedString methodName, std::vector<MaybeOwnedString> pieces);
 
+    CallAwaiter coCall(MaybeOwnedString methodName, MaybeOwnedString payload);
+    CallAwaiter coCall(MaybeOwnedString methodName, std::vector<MaybeOwnedString> pieces);
+
     size_t numPendingRequests() const {
         return requester_.numPendingRequests();
     }
@@ -12,6 +12,7 @@
 #include <utility>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/message/MultiplexingReplier.h"
 #include "mq/net/Endpoint.h"
 #include "mq/utils/Executor.h"
@@ -90,6 +91,30 @@ public:
         replier_.setKeepAlive(keepAlive);
     }
 
+    void setZeroCopyThreshold(size_t zeroCopyThreshold) {
+        replier_.setZeroCopyThreshold(zeroCopyThreshold);
+    }
+
+    void setWriteCoalescing(bool writeCoalescing) {
+        replier_.setWriteCoalescing(writeCoalescing);
+    }
+
+    void setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+        replier_.setWriteCoalescingDelay(writeCoalescingDelay);
+    }
+
+    void setWorkerGroup(EventLoopGroup *workerGroup) {
+        replier_.setWorkerGroup(workerGroup);
+    }
+
+    void setSharded(bool sharded) {
+        replier_.setSharded(sharded);
+    }
+
+    void setCpuSteering(bool cpuSteering) {
+        replier_.setCpuSteering(cpuSteering);
+    }
+
     bool hasMethod(std::string_view methodName) const;
     void registerMethod(std::string methodName, Method method, Executor *methodExecutor = nullptr);
     void unregisterMethod(std::string_view methodName);
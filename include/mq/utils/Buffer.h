@@ -7,6 +7,8 @@
 
 namespace mq {
 
+class BufferPool;
+
 class Buffer {
 public:
     explicit Buffer(size_t maxCapacity = std::numeric_limits<size_t>::max());
@@ -30,6 +32,10 @@ public:
         return end_ - begin_;
     }
 
+    size_t spare() const {
+        return capacity_ - end_;
+    }
+
     bool empty() const {
         return begin_ == end_;
     }
@@ -50,13 +56,19 @@ public:
         return buffer_[i];
     }
 
+    BufferPool *pool() const {
+        return pool_;
+    }
+
     void setMaxCapacity(size_t maxCapacity);
+    void setPool(BufferPool *pool);
     void extend(size_t size);
     void retractFront(size_t size);
     void retractBack(size_t size);
     void clear();
     void reserve(size_t size);
     void shrinkToFit();
+    void release();
     void swap(Buffer &other) noexcept;
 
 private:
@@ -64,6 +76,7 @@ private:
     size_t capacity_;
     size_t begin_, end_;
     char *buffer_;
+    BufferPool *pool_;
 
     void reallocate(size_t newCapacity);
     void move();
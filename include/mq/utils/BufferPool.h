@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mq {
+
+class BufferPool {
+public:
+    struct Stats {
+        size_t pooledBytes = 0;
+        size_t inUseBytes = 0;
+        uint64_t allocations = 0;
+        uint64_t hits = 0;
+        uint64_t deallocations = 0;
+        uint64_t evictions = 0;
+    };
+
+    static constexpr size_t kMinSizeClassShift = 9;
+    static constexpr size_t kMaxSizeClassShift = 20;
+    static constexpr size_t kNumSizeClasses = kMaxSizeClassShift - kMinSizeClassShift + 1;
+
+    explicit BufferPool(size_t budget = 64 * 1024 * 1024);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool(BufferPool &&) = delete;
+
+    BufferPool &operator=(const BufferPool &) = delete;
+    BufferPool &operator=(BufferPool &&) = delete;
+
+    size_t budget() const {
+        return budget_;
+    }
+
+    const Stats &stats() const {
+        return stats_;
+    }
+
+    void setBudget(size_t budget);
+    char *allocate(size_t &size);
+    void deallocate(char *data, size_t size);
+    void trim(size_t budget = 0);
+
+    static size_t roundUp(size_t size);
+
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    size_t budget_;
+    std::array<FreeBlock *, kNumSizeClasses> freeLists_{};
+    Stats stats_;
+};
+
+} // namespace mq
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace mq {
+
+using CallbackId = size_t;
+
+template <typename Signature>
+class CallbackList;
+
+template <typename... Args>
+class CallbackList<bool (Args...)> {
+public:
+    using Callback = std::move_only_function<bool (Args...)>;
+
+    CallbackList() = default;
+
+    CallbackList(const CallbackList &) = delete;
+    CallbackList(CallbackList &&) = delete;
+
+    CallbackList &operator=(const CallbackList &) = delete;
+    CallbackList &operator=(CallbackList &&) = delete;
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    CallbackId add(Callback callback) {
+        CallbackId id = ++lastId_;
+
+        if (depth_ == 0) {
+            entries_.emplace_back(std::move(callback), id, true);
+        } else {
+            added_.emplace_back(std::move(callback), id, true);
+        }
+
+        ++size_;
+
+        return id;
+    }
+
+    void remove(CallbackId id) {
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->id != id || !it->alive) continue;
+
+            if (depth_ == 0) {
+                entries_.erase(it);
+            } else {
+                it->alive = false;
+                dirty_ = true;
+            }
+
+            --size_;
+            return;
+        }
+
+        for (auto it = added_.begin(); it != added_.end(); ++it) {
+            if (it->id != id) continue;
+
+            added_.erase(it);
+            --size_;
+            return;
+        }
+    }
+
+    void clear() {
+        if (depth_ == 0) {
+            entries_.clear();
+        } else {
+            for (Entry &entry : entries_) {
+                entry.alive = false;
+            }
+
+            dirty_ = true;
+        }
+
+        added_.clear();
+        size_ = 0;
+    }
+
+    void dispatch(Args... args) {
+        ++depth_;
+
+        size_t n = entries_.size();
+
+        for (size_t i = 0; i < n; ++i) {
+            if (!entries_[i].alive) continue;
+
+            if (!entries_[i].callback(args...) && entries_[i].alive) {
+                entries_[i].alive = false;
+                dirty_ = true;
+                --size_;
+            }
+        }
+
+        if (--depth_ == 0) {
+            if (dirty_) {
+                std::erase_if(entries_, [](const Entry &entry) { return !entry.alive; });
+                dirty_ = false;
+            }
+
+            for (Entry &entry : added_) {
+                entries_.emplace_back(std::move(entry));
+            }
+
+            added_.clear();
+        }
+    }
+
+private:
+    struct Entry {
+        Callback callback;
+        CallbackId id;
+        bool alive;
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> added_;
+    CallbackId lastId_ = 0;
+    size_t size_ = 0;
+    size_t depth_ = 0;
+    bool dirty_ = false;
+};
+
+} // namespace mq
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace mq {
+
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double nanosecondsPerCycle();
+
+inline std::chrono::nanoseconds cyclesToNanoseconds(uint64_t cycles) {
+    return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(cycles) * nanosecondsPerCycle()));
+}
+
+} // namespace mq
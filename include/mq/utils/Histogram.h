@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace mq {
+
+class Histogram {
+public:
+    static constexpr size_t kSubBuckets = 4;
+    static constexpr size_t kNumBuckets = (64 - 1) * kSubBuckets;
+
+    void record(uint64_t value) {
+        ++buckets_[bucketIndex(value)];
+        ++count_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void reset() {
+        buckets_.fill(0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+    }
+
+    uint64_t count() const {
+        return count_;
+    }
+
+    uint64_t sum() const {
+        return sum_;
+    }
+
+    uint64_t min() const {
+        return count_ == 0 ? 0 : min_;
+    }
+
+    uint64_t max() const {
+        return max_;
+    }
+
+    uint64_t mean() const {
+        return count_ == 0 ? 0 : sum_ / count_;
+    }
+
+    uint64_t percentile(double p) const {
+        if (count_ == 0) return 0;
+
+        uint64_t rank = static_cast<uint64_t>(p / 100 * static_cast<double>(count_ - 1)) + 1;
+        uint64_t seen = 0;
+
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            seen += buckets_[i];
+
+            if (seen >= rank) {
+                return std::clamp(bucketUpperBound(i), min_, max_);
+            }
+        }
+
+        return max_;
+    }
+
+    const std::array<uint64_t, kNumBuckets> &buckets() const {
+        return buckets_;
+    }
+
+    static constexpr size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) return value;
+
+        size_t exponent = std::bit_width(value) - 1;
+        size_t subBucket = (value >> (exponent - 2)) & (kSubBuckets - 1);
+
+        return (exponent - 1) * kSubBuckets + subBucket;
+    }
+
+    static constexpr uint64_t bucketLowerBound(size_t index) {
+        if (index < kSubBuckets) return index;
+
+        size_t exponent = index / kSubBuckets + 1;
+        size_t subBucket = index % kSubBuckets;
+
+        return (kSubBuckets + subBucket) << (exponent - 2);
+    }
+
+    static constexpr uint64_t bucketUpperBound(size_t index) {
+        return index + 1 < kNumBuckets ? bucketLowerBound(index + 1) - 1 : std::numeric_limits<uint64_t>::max();
+    }
+
+private:
+    std::array<uint64_t, kNumBuckets> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = std::numeric_limits<uint64_t>::max();
+    uint64_t max_ = 0;
+};
+
+} // namespace mq
@@ -201,6 +201,10 @@ public:
         return 0;
     }
 
+    void moveToBack(const_iterator i) {
+        list_.splice(list_.end(), list_, i);
+    }
+
     void clear() {
         list_.clear();
         map_.clear();
@@ -389,6 +393,10 @@ public:
         return 0;
     }
 
+    void moveToBack(const_iterator i) {
+        list_.splice(list_.end(), list_, i);
+    }
+
     void clear() {
         list_.clear();
         map_.clear();
@@ -7,8 +7,11 @@
 #include <functional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <variant>
 
+#include "mq/utils/SharedBuffer.h"
+
 namespace mq {
 
 class MaybeOwnedString {
@@ -31,6 +34,9 @@ public:
     constexpr MaybeOwnedString(const char *value, size_t size)
         : value_(std::string_view(value, size)) {}
 
+    MaybeOwnedString(SharedBuffer value)
+        : value_(std::move(value)) {}
+
     constexpr operator std::string() const & {
         return std::visit([](const auto &value) { return std::string(value); }, value_);
     }
@@ -51,8 +57,13 @@ public:
         return std::visit([](const auto &value) { return value.size(); }, value_);
     }
 
+    template <typename Visitor>
+    constexpr decltype(auto) visit(Visitor &&visitor) && {
+        return std::visit(std::forward<Visitor>(visitor), std::move(value_));
+    }
+
 private:
-    std::variant<std::string, std::string_view> value_;
+    std::variant<std::string, std::string_view, SharedBuffer> value_;
 };
 
 } // namespace mq
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace mq {
+
+template <typename T>
+    requires std::is_nothrow_move_constructible_v<T>
+class MpscQueue {
+public:
+    MpscQueue()
+        : head_(&stub_), tail_(&stub_) {}
+
+    ~MpscQueue() {
+        while (tryPop()) {}
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue(MpscQueue &&) = delete;
+
+    MpscQueue& operator=(const MpscQueue &) = delete;
+    MpscQueue& operator=(MpscQueue &&) = delete;
+
+    void push(T value) {
+        link(new Node(std::move(value)));
+    }
+
+    std::optional<T> tryPop() {
+        NodeBase *tail = tail_;
+        NodeBase *next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &stub_) {
+            if (next == nullptr) return std::nullopt;
+
+            tail_ = tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next == nullptr) {
+            if (tail != head_.load(std::memory_order_acquire)) return std::nullopt;
+
+            link(&stub_);
+
+            next = tail->next.load(std::memory_order_acquire);
+
+            if (next == nullptr) return std::nullopt;
+        }
+
+        tail_ = next;
+
+        Node *node = static_cast<Node *>(tail);
+        std::optional<T> value(std::move(node->value));
+        delete node;
+        return value;
+    }
+
+    bool empty() const {
+        return tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_;
+    }
+
+private:
+    struct NodeBase {
+        std::atomic<NodeBase *> next = nullptr;
+    };
+
+    struct Node : NodeBase {
+        T value;
+
+        explicit Node(T value)
+            : value(std::move(value)) {}
+    };
+
+    std::atomic<NodeBase *> head_;
+    NodeBase *tail_;
+    NodeBase stub_;
+
+    void link(NodeBase *node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        NodeBase *prev = head_.exchange(node, std::memory_order_seq_cst);
+        prev->next.store(node, std::memory_order_release);
+    }
+};
+
+} // namespace mq
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <variant>
+
+#include <sys/uio.h>
+
+#include "mq/utils/Buffer.h"
+#include "mq/utils/BufferPool.h"
+#include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SharedBuffer.h"
+
+namespace mq {
+
+class SendQueue {
+public:
+    explicit SendQueue(size_t maxSize = std::numeric_limits<size_t>::max());
+
+    SendQueue(const SendQueue &) = delete;
+    SendQueue(SendQueue &&) = delete;
+
+    SendQueue &operator=(const SendQueue &) = delete;
+    SendQueue &operator=(SendQueue &&) = delete;
+
+    size_t maxSize() const {
+        return maxSize_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t numSegments() const {
+        return segments_.size();
+    }
+
+    size_t numRetiredSegments() const {
+        return retired_.size();
+    }
+
+    BufferPool *pool() const {
+        return pool_;
+    }
+
+    void setMaxSize(size_t maxSize);
+    void setPool(BufferPool *pool);
+    void append(const char *data, size_t size);
+    void append(MaybeOwnedString data, size_t offset = 0);
+    size_t fill(iovec *iovs, size_t maxIovecs) const;
+    void consume(size_t size);
+    void consumeZeroCopy(size_t size, uint32_t id);
+    void releaseZeroCopy(uint32_t id);
+    void moveRetiredTo(SendQueue &other);
+    void clear();
+    std::string toString() const;
+
+private:
+    struct Segment {
+        std::variant<Buffer, std::string, SharedBuffer> data;
+        size_t offset;
+        bool pinned = false;
+        uint32_t pinId = 0;
+
+        const char *begin() const;
+        size_t size() const;
+    };
+
+    size_t maxSize_;
+    size_t size_ = 0;
+    BufferPool *pool_ = nullptr;
+    std::deque<Segment> segments_;
+    std::deque<Segment> retired_;
+
+    void retirePinned();
+    void consume(size_t size, bool zeroCopy, uint32_t id);
+};
+
+} // namespace mq
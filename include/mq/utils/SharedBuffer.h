@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace mq {
+
+class SharedBuffer {
+public:
+    SharedBuffer() = default;
+
+    explicit SharedBuffer(size_t size)
+        : data_(std::make_shared_for_overwrite<char[]>(size)), offset_(0), size_(size) {}
+
+    SharedBuffer(const char *data, size_t size)
+        : SharedBuffer(size) {
+        memcpy(data_.get(), data, size);
+    }
+
+    explicit SharedBuffer(std::string_view data)
+        : SharedBuffer(data.data(), data.size()) {}
+
+    operator std::string_view() const {
+        return std::string_view(data(), size_);
+    }
+
+    const char *data() const {
+        return data_.get() + offset_;
+    }
+
+    char *mutableData() {
+        return data_.get() + offset_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    long useCount() const {
+        return data_.use_count();
+    }
+
+    SharedBuffer slice(size_t offset, size_t size) const {
+        assert(offset + size <= size_);
+
+        SharedBuffer result;
+        result.data_ = data_;
+        result.offset_ = offset_ + offset;
+        result.size_ = size;
+        return result;
+    }
+
+    SharedBuffer slice(size_t offset) const {
+        assert(offset <= size_);
+
+        return slice(offset, size_ - offset);
+    }
+
+private:
+    std::shared_ptr<char[]> data_;
+    size_t offset_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace mq
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/coro/Awaitables.h"
+
+#include <cerrno>
+#include <coroutine>
+
+#include "mq/event/EventLoop.h"
+#include "mq/event/Timer.h"
+#include "mq/net/FramingSocket.h"
+#include "mq/utils/Check.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "Awaitables"
+
+using namespace mq;
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    LOG(debug, "delay={}", delay_);
+
+    if (delay_.count() > 0) {
+        loop_->postTimed([handle] { handle.resume(); }, delay_);
+    } else {
+        loop_->post([handle] { handle.resume(); });
+    }
+}
+
+void ExpireAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    LOG(debug, "");
+
+    CHECK(timer_->loop()->isInLoopThread());
+
+    timer_->addExpireCallback([handle] {
+        handle.resume();
+        return false;
+    });
+}
+
+bool ConnectAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    LOG(debug, "remoteEndpoint={}", *remoteEndpoint_);
+
+    CHECK(socket_->loop()->isInLoopThread());
+
+    handle_ = handle;
+
+    socket_->addConnectCallback([this](int error) {
+        error_ = error;
+
+        if (suspended_) {
+            handle_.resume();
+        } else {
+            completed_ = true;
+        }
+
+        return false;
+    });
+
+    socket_->open(*remoteEndpoint_);
+
+    if (completed_) return false;
+
+    suspended_ = true;
+
+    return true;
+}
+
+bool SendCompleteAwaiter::await_ready() {
+    CHECK(socket_->loop()->isInLoopThread());
+
+    if (socket_->state() != FramingSocket::State::kConnected) {
+        error_ = ENOTCONN;
+        return true;
+    }
+
+    return socket_->socket().sendBufferSize() == 0;
+}
+
+void SendCompleteAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    LOG(debug, "");
+
+    handle_ = handle;
+
+    // Whichever callback fires first removes the other, so awaiting in a loop does not accumulate callbacks.
+    sendCompleteId_ = socket_->addSendCompleteCallback([this] {
+        socket_->removeCloseCallback(closeId_);
+        handle_.resume();
+
+        return false;
+    });
+
+    closeId_ = socket_->addCloseCallback([this](int error) {
+        socket_->removeSendCompleteCallback(sendCompleteId_);
+        error_ = error != 0 ? error : ENOTCONN;
+        handle_.resume();
+
+        return false;
+    });
+}
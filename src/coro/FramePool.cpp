@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/coro/FramePool.h"
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+using namespace mq;
+
+namespace {
+
+constexpr size_t kGranularity = 64;
+constexpr size_t kNumSizeClasses = 32;
+constexpr size_t kMaxPooledSize = kGranularity * kNumSizeClasses;
+constexpr size_t kMaxFreeFrames = 256;
+
+struct FreeFrame {
+    FreeFrame *next;
+};
+
+class Pool {
+public:
+    ~Pool() {
+        for (size_t i = 0; i < kNumSizeClasses; ++i) {
+            while (FreeFrame *frame = freeLists_[i]) {
+                freeLists_[i] = frame->next;
+                ::operator delete(frame);
+            }
+        }
+    }
+
+    void *allocate(size_t sizeClass) {
+        if (FreeFrame *frame = freeLists_[sizeClass]) {
+            freeLists_[sizeClass] = frame->next;
+            --numFreeFrames_[sizeClass];
+            return frame;
+        }
+
+        return ::operator new((sizeClass + 1) * kGranularity);
+    }
+
+    void deallocate(void *ptr, size_t sizeClass) {
+        if (numFreeFrames_[sizeClass] == kMaxFreeFrames) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        FreeFrame *frame = static_cast<FreeFrame *>(ptr);
+        frame->next = freeLists_[sizeClass];
+        freeLists_[sizeClass] = frame;
+        ++numFreeFrames_[sizeClass];
+    }
+
+private:
+    std::array<FreeFrame *, kNumSizeClasses> freeLists_{};
+    std::array<size_t, kNumSizeClasses> numFreeFrames_{};
+};
+
+thread_local Pool pool;
+
+size_t sizeClassOf(size_t size) {
+    return (size - 1) / kGranularity;
+}
+
+} // namespace
+
+void *FramePool::allocate(size_t size) {
+    if (size == 0 || size > kMaxPooledSize) {
+        return ::operator new(size);
+    }
+
+    return pool.allocate(sizeClassOf(size));
+}
+
+void FramePool::deallocate(void *ptr, size_t size) {
+    if (size == 0 || size > kMaxPooledSize) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    pool.deallocate(ptr, sizeClassOf(size));
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/coro/FramingReceiver.h"
+
+#include <coroutine>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "mq/net/FramingSocket.h"
+#include "mq/utils/Check.h"
+#include "mq/utils/Empty.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "FramingReceiver"
+
+using namespace mq;
+
+FramingReceiver::FramingReceiver(FramingSocket *socket)
+    : socket_(socket), token_(std::make_shared<Empty>()) {
+    LOG(debug, "");
+
+    CHECK(socket_->loop()->isInLoopThread());
+
+    socket_->addRecvCallback([this, token = std::weak_ptr(token_)](std::string_view message) {
+        if (token.expired()) return false;
+
+        onSocketRecv(message);
+
+        return true;
+    });
+
+    socket_->addCloseCallback([this, token = std::weak_ptr(token_)](int error) {
+        if (token.expired()) return false;
+
+        onSocketClose(error);
+
+        return true;
+    });
+}
+
+FramingReceiver::~FramingReceiver() {
+    LOG(debug, "");
+
+    CHECK(!waiter_);
+}
+
+bool FramingReceiver::RecvAwaiter::await_ready() const {
+    return !receiver_->messages_.empty() || receiver_->closed_;
+}
+
+void FramingReceiver::RecvAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    CHECK(!receiver_->waiter_);
+
+    receiver_->waiter_ = handle;
+}
+
+std::optional<std::string> FramingReceiver::RecvAwaiter::await_resume() {
+    if (receiver_->messages_.empty()) return std::nullopt;
+
+    std::string message = std::move(receiver_->messages_.front());
+    receiver_->messages_.pop_front();
+
+    return message;
+}
+
+void FramingReceiver::onSocketRecv(std::string_view message) {
+    LOG(debug, "message: size={}", message.size());
+
+    messages_.emplace_back(message);
+
+    if (waiter_) {
+        std::exchange(waiter_, nullptr).resume();
+    }
+}
+
+void FramingReceiver::onSocketClose(int error) {
+    LOG(debug, "error={}", strerrorname_np(error));
+
+    closed_ = true;
+    error_ = error;
+
+    if (waiter_) {
+        std::exchange(waiter_, nullptr).resume();
+    }
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/event/EpollPoller.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "mq/utils/Check.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "EpollPoller"
+
+using namespace mq;
+
+EpollPoller::EpollPoller() {
+    CHECK((epollFd_ = epoll_create1(EPOLL_CLOEXEC)) >= 0);
+
+    LOG(debug, "epollFd={}", epollFd_);
+}
+
+EpollPoller::~EpollPoller() {
+    LOG(debug, "");
+
+    CHECK(close(epollFd_) == 0);
+}
+
+void EpollPoller::add(int fd, uint32_t events, uint64_t data) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = data;
+
+    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0);
+}
+
+void EpollPoller::modify(int fd, uint32_t events, uint64_t data) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = data;
+
+    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == 0);
+}
+
+void EpollPoller::remove(int fd) {
+    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr) == 0);
+}
+
+int EpollPoller::wait(Event *events, int maxEvents, int timeout) {
+    constexpr int kMaxEvents = 256;
+    epoll_event epollEvents[kMaxEvents];
+
+    int n = epoll_wait(epollFd_, epollEvents, std::min(maxEvents, kMaxEvents), timeout);
+    LOG(debug, "epoll_wait: n={}", n);
+
+    for (int i = 0; i < n; ++i) {
+        events[i].data = epollEvents[i].data.u64;
+        events[i].events = epollEvents[i].events;
+    }
+
+    return n;
+}
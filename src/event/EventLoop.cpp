@@ -2,14 +2,16 @@
 
 #include "mq/event/EventLoop.h"
 
+#include <atomic>
 #include <cerrno>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <future>
-#include <iterator>
-#include <mutex>
+#include <memory>
+#include <optional>
+#include <string>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -20,30 +22,45 @@
 #include <unistd.h>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/Poller.h"
 #include "mq/event/Watcher.h"
 #include "mq/utils/Check.h"
+#include "mq/utils/Cycles.h"
 #include "mq/utils/Logging.h"
 
 #define TAG "EventLoop"
 
 using namespace mq;
 
+namespace {
+
+#ifdef LIBMQ_IO_URING
+constexpr Poller::Backend kDefaultBackend = Poller::Backend::kIoUring;
+#else
+constexpr Poller::Backend kDefaultBackend = Poller::Backend::kEpoll;
+#endif
+
+} // namespace
+
 thread_local EventLoop *EventLoop::loop_ = nullptr;
 
-EventLoop::EventLoop() {
-    LOG(debug, "");
+EventLoop::EventLoop()
+    : EventLoop(kDefaultBackend) {}
+
+EventLoop::EventLoop(Poller::Backend backend) {
+    LOG(debug, "backend={}", backend);
 
     CHECK(loop_ == nullptr);
 
-    CHECK((epollFd_ = epoll_create1(EPOLL_CLOEXEC)) >= 0);
+    poller_ = Poller::create(backend);
+
     CHECK((eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) >= 0);
+    CHECK((timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) >= 0);
 
-    LOG(debug, "epollFd={}, eventFd={}", epollFd_, eventFd_);
+    LOG(debug, "backend={}, eventFd={}, timerFd={}", poller_->backend(), eventFd_, timerFd_);
 
-    epoll_event event{};
-    event.events = EPOLLIN;
-    event.data.fd = eventFd_;
-    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, eventFd_, &event) == 0);
+    poller_->add(eventFd_, EPOLLIN, eventFd_);
+    poller_->add(timerFd_, EPOLLIN, timerFd_);
 
     loop_ = this;
 }
@@ -53,27 +70,92 @@ EventLoop::~EventLoop() {
 
     CHECK(isInLoopThread());
 
+    poller_->remove(timerFd_);
+    poller_->remove(eventFd_);
+
+    CHECK(close(timerFd_) == 0);
     CHECK(close(eventFd_) == 0);
-    CHECK(close(epollFd_) == 0);
+
+    poller_.reset();
 
     loop_ = nullptr;
 }
 
+void EventLoop::setBusyPoll(std::chrono::nanoseconds busyPoll) {
+    LOG(debug, "busyPoll={}", busyPoll);
+
+    CHECK(isInLoopThread());
+    CHECK(busyPoll.count() >= 0);
+
+    busyPoll_ = busyPoll;
+    busyPollDeadline_ = TimerQueue::Clock::time_point{};
+}
+
+void EventLoop::setStatsDumpInterval(std::chrono::nanoseconds statsDumpInterval) {
+    LOG(debug, "statsDumpInterval={}", statsDumpInterval);
+
+    CHECK(isInLoopThread());
+    CHECK(statsDumpInterval.count() >= 0);
+
+    if (statsDumpTimerId_ != 0) {
+        cancelTimer(statsDumpTimerId_);
+        statsDumpTimerId_ = 0;
+    }
+
+    statsDumpInterval_ = statsDumpInterval;
+
+    if (statsDumpInterval_.count() > 0) {
+        scheduleStatsDump();
+    }
+}
+
+void EventLoop::setBufferPoolBudget(size_t bufferPoolBudget) {
+    LOG(debug, "bufferPoolBudget={}", bufferPoolBudget);
+
+    CHECK(isInLoopThread());
+
+    bufferPool_.setBudget(bufferPoolBudget);
+}
+
 EventLoop::State EventLoop::state() const {
     CHECK(isInLoopThread());
 
     return state_;
 }
 
+Poller::Backend EventLoop::backend() const {
+    return poller_->backend();
+}
+
+BufferPool *EventLoop::bufferPool() {
+    return &bufferPool_;
+}
+
+EventLoop::Stats EventLoop::stats() const {
+    CHECK(isInLoopThread());
+
+    return stats_;
+}
+
+void EventLoop::resetStats() {
+    CHECK(isInLoopThread());
+
+    stats_ = Stats();
+}
+
 void EventLoop::post(Task task) {
     LOG(debug, "");
 
-    {
-        std::unique_lock lock(tasksMutex_);
-        tasks_.emplace_back(std::move(task));
+    if (isInLoopThread()) {
+        localTasks_.emplace_back(std::move(task));
+        return;
     }
 
-    wakeUp();
+    tasks_.push(std::move(task));
+
+    if (sleeping_.load(std::memory_order_seq_cst) && sleeping_.exchange(false, std::memory_order_seq_cst)) {
+        wakeUp();
+    }
 }
 
 void EventLoop::postTimed(TimedTask task, std::chrono::nanoseconds delay) {
@@ -81,28 +163,15 @@ void EventLoop::postTimed(TimedTask task, std::chrono::nanoseconds delay) {
 
     CHECK(delay.count() > 0);
 
-    int timerFd;
-    CHECK((timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) >= 0);
+    TimerQueue::Clock::time_point expiry = TimerQueue::Clock::now() + delay;
 
-    LOG(debug, "timerFd={}", timerFd);
-
-    itimerspec newValue{};
-    newValue.it_value.tv_sec = delay.count() / 1'000'000'000;
-    newValue.it_value.tv_nsec = delay.count() % 1'000'000'000;
-
-    CHECK(timerfd_settime(timerFd, 0, &newValue, nullptr) == 0);
-
-    {
-        std::unique_lock lock(timedTasksMutex_);
-        timedTasks_.emplace(timerFd, std::move(task));
+    if (isInLoopThread()) {
+        addTimer(expiry, std::move(task));
+    } else {
+        post([this, task = std::move(task), expiry] mutable {
+            addTimer(expiry, std::move(task));
+        });
     }
-
-    epoll_event event{};
-    event.events = EPOLLIN;
-    event.data.fd = timerFd;
-    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd, &event) == 0);
-
-    wakeUp();
 }
 
 void EventLoop::run() {
@@ -111,20 +180,59 @@ void EventLoop::run() {
     CHECK(isInLoopThread());
 
     constexpr size_t kMaxEvents = 256;
-    epoll_event events[kMaxEvents];
+    Poller::Event events[kMaxEvents];
 
     for (;;) {
-        int n = epoll_wait(epollFd_, events, kMaxEvents, -1);
-        LOG(debug, "epoll_wait: n={}", n);
+        applyWatcherUpdates();
+
+        bool spinning = busyPoll_.count() > 0 && TimerQueue::Clock::now() < busyPollDeadline_;
+
+        if (!spinning) {
+            sleeping_.store(true, std::memory_order_seq_cst);
+        }
+
+        int timeout = spinning || !localTasks_.empty() || !tasks_.empty() || !pendingWatchers_.empty() ||
+                      !flushWatchers_.empty() ? 0 : -1;
+
+        int n = poller_->wait(events, kMaxEvents, timeout);
+        LOG(debug, "wait: timeout={}, n={}", timeout, n);
+
+        if (!spinning) {
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+
+        if (n > 0 && busyPoll_.count() > 0) {
+            TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+
+            if (lastEventTime_ != TimerQueue::Clock::time_point{}) {
+                eventInterval_ += (now - lastEventTime_ - eventInterval_) / 8;
+            }
+
+            lastEventTime_ = now;
+
+            if (eventInterval_ <= busyPoll_) {
+                busyPollDeadline_ = now + busyPoll_;
+            }
+        }
 
         if (n < 0) {
-            LOG(debug, "epoll_wait: errno={}", strerrorname_np(errno));
+            LOG(debug, "wait: errno={}", strerrorname_np(errno));
             CHECK(errno == EINTR);
             continue;
         }
 
+        uint64_t iterationStart = readCycles();
+
+        ++stats_.iterations;
+        if (timeout != 0) {
+            ++stats_.wakeUps;
+        }
+        stats_.events += n;
+        stats_.eventsPerIteration.record(n);
+
         for (int i = 0; i < n; ++i) {
-            int fd = events[i].data.fd;
+            int fd = static_cast<int>(static_cast<uint32_t>(events[i].data));
+            uint32_t generation = static_cast<uint32_t>(events[i].data >> 32);
             uint32_t eventsMask = events[i].events;
 
             LOG(debug, "fd={}, eventsMask={}", fd, eventsMask);
@@ -134,178 +242,394 @@ void EventLoop::run() {
 
                 uint64_t value;
                 CHECK(read(eventFd_, &value, sizeof(value)) == sizeof(value));
+            } else if (fd == timerFd_) {
+                LOG(debug, "timerFd");
+
+                runTimers();
             } else {
-                TimedTask timedTask;
-                {
-                    std::unique_lock lock(timedTasksMutex_);
-                    if (auto j = timedTasks_.find(fd); j != timedTasks_.end()) {
-                        timedTask = std::move(j->second);
-                        timedTasks_.erase(j);
+                const WatcherSlot &slot = watchers_[fd];
+
+                if (slot.watcher == nullptr || slot.generation != generation) {
+                    LOG(debug, "fd={}, stale", fd);
+                    continue;
+                }
+
+                if (slot.edgeTriggered) {
+                    if (eventsMask & (EPOLLERR | EPOLLHUP)) {
+                        eventsMask |= EPOLLIN | EPOLLOUT | EPOLLERR;
                     }
+
+                    watchers_[fd].readyEvents |= eventsMask & (EPOLLIN | EPOLLOUT | EPOLLERR);
+                    schedulePendingWatcher(fd);
+                    continue;
                 }
 
-                if (timedTask) {
-                    LOG(debug, "fd={}, timedTask", fd);
+                Watcher *watcher = slot.watcher;
 
-                    uint64_t value;
-                    CHECK(read(fd, &value, sizeof(value)) == sizeof(value));
+                if ((eventsMask & (EPOLLERR | EPOLLHUP)) && watcher->hasErrorCallback()) {
+                    LOG(debug, "fd={}, EPOLLERR", fd);
 
-                    state_ = State::kTimedTask;
-                    timedTask();
-                    state_ = State::kIdle;
+                    dispatchError(watcher);
+                }
 
-                    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr) == 0);
-                    CHECK(close(fd) == 0);
-                } else {
-                    Watcher *watcher;
-                    {
-                        std::unique_lock lock(watchersMutex_);
-                        watcher = watchers_.find(fd)->second;
-                    }
+                if (eventsMask & EPOLLERR) {
+                    eventsMask |= EPOLLIN;
+                }
 
-                    if (eventsMask & EPOLLIN) {
-                        LOG(debug, "fd={}, EPOLLIN", fd);
+                if (eventsMask & EPOLLIN) {
+                    LOG(debug, "fd={}, EPOLLIN", fd);
 
-                        state_ = State::kCallback;
-                        watcher->dispatchReadReady();
-                        state_ = State::kIdle;
+                    dispatchReadReady(watcher);
 
-                        if (!watcher->hasReadReadyCallback()) {
-                            updateWatcher(watcher);
-                        }
+                    if (!watcher->hasReadReadyCallback()) {
+                        updateWatcher(watcher);
                     }
+                }
 
-                    if (eventsMask & EPOLLOUT) {
-                        LOG(debug, "fd={}, EPOLLOUT", fd);
+                if (eventsMask & EPOLLOUT) {
+                    LOG(debug, "fd={}, EPOLLOUT", fd);
 
-                        state_ = State::kCallback;
-                        watcher->dispatchWriteReady();
-                        state_ = State::kIdle;
+                    dispatchWriteReady(watcher);
 
-                        if (!watcher->hasWriteReadyCallback()) {
-                            updateWatcher(watcher);
-                        }
+                    if (!watcher->hasWriteReadyCallback()) {
+                        updateWatcher(watcher);
                     }
                 }
             }
         }
 
+        dispatchPendingWatchers();
+
         state_ = State::kTask;
 
         {
             std::vector<Task> tasks;
-            {
-                std::unique_lock lock(tasksMutex_);
+            tasks.swap(localTasks_);
 
-                constexpr size_t kMaxTasks = 256;
+            constexpr size_t kMaxTasks = 256;
 
-                if (tasks_.size() <= kMaxTasks) {
-                    tasks.swap(tasks_);
-                } else {
-                    tasks.insert(tasks.end(),
-                                 std::make_move_iterator(tasks_.begin()),
-                                 std::make_move_iterator(tasks_.begin() + kMaxTasks));
+            size_t i = 0;
 
-                    tasks_.erase(tasks_.begin(), tasks_.begin() + kMaxTasks);
+            for (; i < kMaxTasks; ++i) {
+                std::optional<Task> task = tasks_.tryPop();
 
-                    wakeUp();
-                }
+                if (!task) break;
+
+                tasks.emplace_back(std::move(*task));
             }
+
+            if (i == kMaxTasks && !tasks_.empty()) {
+                ++stats_.taskOverflows;
+            }
+
+            uint64_t taskStart = readCycles();
+
             for (Task &task : tasks) {
                 LOG(debug, "task");
 
                 task();
+                task = nullptr;
             }
+
+            stats_.tasks += tasks.size();
+            stats_.taskTime += cyclesToNanoseconds(readCycles() - taskStart);
+            stats_.tasksPerIteration.record(tasks.size());
         }
 
         state_ = State::kIdle;
+
+        dispatchWatcherFlushes();
+
+        stats_.iterationLatency.record(cyclesToNanoseconds(readCycles() - iterationStart).count());
     }
 }
 
 bool EventLoop::hasWatcher(int fd) {
-    std::unique_lock lock(watchersMutex_);
-    return watchers_.find(fd) != watchers_.end();
+    CHECK(isInLoopThread());
+
+    return static_cast<size_t>(fd) < watchers_.size() && watchers_[fd].watcher != nullptr;
 }
 
 void EventLoop::addWatcher(Watcher *watcher) {
     LOG(debug, "fd={}", watcher->fd_);
 
-    std::unique_lock lock(watchersMutex_);
+    CHECK(isInLoopThread());
 
-    CHECK(watchers_.emplace(watcher->fd_, watcher).second);
+    int fd = watcher->fd_;
 
-    epoll_event event{};
-    if (watcher->hasReadReadyCallback()) {
-        event.events |= EPOLLIN;
-    }
-    if (watcher->hasWriteReadyCallback()) {
-        event.events |= EPOLLOUT;
+    CHECK(fd >= 0);
+
+    if (static_cast<size_t>(fd) >= watchers_.size()) {
+        watchers_.resize(fd + 1);
     }
-    event.data.fd = watcher->fd_;
 
-    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, watcher->fd_, &event) == 0);
+    WatcherSlot &slot = watchers_[fd];
+
+    CHECK(slot.watcher == nullptr);
 
-    lock.unlock();
+    slot.watcher = watcher;
+    ++slot.generation;
+    slot.edgeTriggered = watcher->edgeTriggered_ && poller_->backend() == Poller::Backend::kEpoll;
+    slot.pending = false;
+    slot.dirty = false;
+    slot.flushScheduled = false;
+    slot.readyEvents = 0;
 
-    wakeUp();
+    if (slot.edgeTriggered) {
+        slot.registeredEvents = EPOLLIN | EPOLLOUT | EPOLLET;
+    } else {
+        slot.registeredEvents = watcherEvents(watcher);
+    }
+
+    poller_->add(fd, slot.registeredEvents, watcherData(fd, slot.generation));
 }
 
 void EventLoop::updateWatcher(Watcher *watcher) {
     LOG(debug, "fd={}", watcher->fd_);
 
-    std::unique_lock lock(watchersMutex_);
+    CHECK(isInLoopThread());
 
-    epoll_event event{};
-    if (watcher->hasReadReadyCallback()) {
-        event.events |= EPOLLIN;
-    }
-    if (watcher->hasWriteReadyCallback()) {
-        event.events |= EPOLLOUT;
+    int fd = watcher->fd_;
+
+    CHECK(hasWatcher(fd));
+
+    WatcherSlot &slot = watchers_[fd];
+
+    if (slot.edgeTriggered) {
+        if (slot.readyEvents & watcherEvents(watcher)) {
+            schedulePendingWatcher(fd);
+        }
+        return;
     }
-    event.data.fd = watcher->fd_;
 
-    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_MOD, watcher->fd_, &event) == 0);
+    ++stats_.watcherUpdates;
 
-    lock.unlock();
+    if (slot.dirty) return;
 
-    wakeUp();
+    slot.dirty = true;
+    dirtyWatchers_.emplace_back(watcherData(fd, slot.generation));
 }
 
 void EventLoop::updateWatcherIfRegistered(Watcher *watcher) {
     LOG(debug, "fd={}", watcher->fd_);
 
-    std::unique_lock lock(watchersMutex_);
+    CHECK(isInLoopThread());
 
-    if (watchers_.find(watcher->fd_) == watchers_.end()) return;
+    int fd = watcher->fd_;
 
-    epoll_event event{};
-    if (watcher->hasReadReadyCallback()) {
-        event.events |= EPOLLIN;
-    }
-    if (watcher->hasWriteReadyCallback()) {
-        event.events |= EPOLLOUT;
+    if (!hasWatcher(fd)) return;
+
+    updateWatcher(watcher);
+}
+
+void EventLoop::removeWatcher(Watcher *watcher) {
+    LOG(debug, "fd={}", watcher->fd_);
+
+    CHECK(isInLoopThread());
+
+    int fd = watcher->fd_;
+
+    CHECK(hasWatcher(fd));
+
+    poller_->remove(fd);
+
+    watchers_[fd].watcher = nullptr;
+}
+
+void EventLoop::applyWatcherUpdates() {
+    for (uint64_t data : dirtyWatchers_) {
+        int fd = static_cast<int>(static_cast<uint32_t>(data));
+        uint32_t generation = static_cast<uint32_t>(data >> 32);
+
+        WatcherSlot &slot = watchers_[fd];
+
+        if (slot.watcher == nullptr || slot.generation != generation) continue;
+
+        slot.dirty = false;
+
+        uint32_t events = watcherEvents(slot.watcher);
+
+        if (events == slot.registeredEvents) continue;
+
+        LOG(debug, "fd={}, events={}", fd, events);
+
+        ++stats_.pollerUpdates;
+
+        poller_->modify(fd, events, data);
+        slot.registeredEvents = events;
     }
-    event.data.fd = watcher->fd_;
 
-    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_MOD, watcher->fd_, &event) == 0);
+    dirtyWatchers_.clear();
+}
+
+void EventLoop::clearWatcherReady(Watcher *watcher, uint32_t events) {
+    LOG(debug, "fd={}, events={}", watcher->fd_, events);
 
-    lock.unlock();
+    CHECK(isInLoopThread());
 
-    wakeUp();
+    int fd = watcher->fd_;
+
+    if (!hasWatcher(fd) || watchers_[fd].watcher != watcher) return;
+
+    watchers_[fd].readyEvents &= ~events;
 }
 
-void EventLoop::removeWatcher(Watcher *watcher) {
+void EventLoop::schedulePendingWatcher(int fd) {
+    WatcherSlot &slot = watchers_[fd];
+
+    if (slot.pending) return;
+
+    slot.pending = true;
+    pendingWatchers_.emplace_back(watcherData(fd, slot.generation));
+}
+
+void EventLoop::dispatchPendingWatchers() {
+    readyWatchers_.swap(pendingWatchers_);
+
+    for (uint64_t data : readyWatchers_) {
+        int fd = static_cast<int>(static_cast<uint32_t>(data));
+        uint32_t generation = static_cast<uint32_t>(data >> 32);
+
+        if (watchers_[fd].watcher == nullptr || watchers_[fd].generation != generation) continue;
+
+        watchers_[fd].pending = false;
+
+        Watcher *watcher = watchers_[fd].watcher;
+
+        // The error is reported once per edge, even while the watcher has no read or write callback.
+        if (watchers_[fd].readyEvents & EPOLLERR) {
+            watchers_[fd].readyEvents &= ~EPOLLERR;
+
+            if (watcher->hasErrorCallback()) {
+                LOG(debug, "fd={}, EPOLLERR", fd);
+
+                dispatchError(watcher);
+            }
+        }
+
+        if ((watchers_[fd].readyEvents & EPOLLIN) && watcher->hasReadReadyCallback()) {
+            LOG(debug, "fd={}, EPOLLIN", fd);
+
+            dispatchReadReady(watcher);
+        }
+
+        if ((watchers_[fd].readyEvents & EPOLLOUT) && watcher->hasWriteReadyCallback()) {
+            LOG(debug, "fd={}, EPOLLOUT", fd);
+
+            dispatchWriteReady(watcher);
+        }
+
+        if (watchers_[fd].readyEvents & watcherEvents(watcher)) {
+            schedulePendingWatcher(fd);
+        }
+    }
+
+    readyWatchers_.clear();
+}
+
+void EventLoop::scheduleWatcherFlush(Watcher *watcher) {
     LOG(debug, "fd={}", watcher->fd_);
 
-    std::unique_lock lock(watchersMutex_);
+    CHECK(isInLoopThread());
+
+    int fd = watcher->fd_;
+
+    CHECK(hasWatcher(fd));
+
+    WatcherSlot &slot = watchers_[fd];
+
+    if (slot.flushScheduled) return;
+
+    slot.flushScheduled = true;
+    flushWatchers_.emplace_back(watcherData(fd, slot.generation));
+}
+
+void EventLoop::dispatchWatcherFlushes() {
+    flushingWatchers_.swap(flushWatchers_);
+
+    for (uint64_t data : flushingWatchers_) {
+        int fd = static_cast<int>(static_cast<uint32_t>(data));
+        uint32_t generation = static_cast<uint32_t>(data >> 32);
+
+        if (watchers_[fd].watcher == nullptr || watchers_[fd].generation != generation) continue;
+
+        watchers_[fd].flushScheduled = false;
+
+        Watcher *watcher = watchers_[fd].watcher;
+
+        LOG(debug, "fd={}, flush", fd);
+
+        ++stats_.flushes;
+
+        state_ = State::kCallback;
+
+        uint64_t start = readCycles();
+        watcher->dispatchFlush();
+        recordCallback(watcher, readCycles() - start);
+
+        state_ = State::kIdle;
+    }
+
+    flushingWatchers_.clear();
+}
+
+void EventLoop::dispatchReadReady(Watcher *watcher) {
+    state_ = State::kCallback;
+
+    uint64_t start = readCycles();
+    watcher->dispatchReadReady();
+    recordCallback(watcher, readCycles() - start);
+
+    state_ = State::kIdle;
+}
+
+void EventLoop::dispatchWriteReady(Watcher *watcher) {
+    state_ = State::kCallback;
+
+    uint64_t start = readCycles();
+    watcher->dispatchWriteReady();
+    recordCallback(watcher, readCycles() - start);
+
+    state_ = State::kIdle;
+}
+
+void EventLoop::dispatchError(Watcher *watcher) {
+    state_ = State::kCallback;
 
-    CHECK(epoll_ctl(epollFd_, EPOLL_CTL_DEL, watcher->fd_, nullptr) == 0);
+    uint64_t start = readCycles();
+    watcher->dispatchError();
+    recordCallback(watcher, readCycles() - start);
+
+    state_ = State::kIdle;
+}
 
-    CHECK(watchers_.erase(watcher->fd_) == 1);
+void EventLoop::recordCallback(Watcher *watcher, uint64_t cycles) {
+    std::chrono::nanoseconds time = cyclesToNanoseconds(cycles);
 
-    lock.unlock();
+    ++stats_.callbacks;
+    stats_.callbackTime += time;
+    stats_.callbackLatency.record(time.count());
+
+    if (time > stats_.longestCallback) {
+        stats_.longestCallback = time;
+        stats_.longestCallbackTag = watcher->tag_;
+        stats_.longestCallbackFd = watcher->fd_;
+    }
+}
+
+uint32_t EventLoop::watcherEvents(Watcher *watcher) {
+    uint32_t events = 0;
+    if (watcher->hasReadReadyCallback()) {
+        events |= EPOLLIN;
+    }
+    if (watcher->hasWriteReadyCallback()) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
 
-    wakeUp();
+uint64_t EventLoop::watcherData(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
 }
 
 void EventLoop::wakeUp() {
@@ -315,12 +639,140 @@ void EventLoop::wakeUp() {
     CHECK(write(eventFd_, &value, sizeof(value)) == sizeof(value));
 }
 
+TimerQueue::TimerId EventLoop::addTimer(TimerQueue::Clock::time_point expiry, TimedTask task) {
+    CHECK(isInLoopThread());
+
+    TimerQueue::TimerId timerId = timers_.add(expiry, std::move(task));
+
+    LOG(debug, "timerId={}", timerId);
+
+    if (expiry < timerFdExpiry_) {
+        setTimerFd(expiry);
+    }
+
+    return timerId;
+}
+
+void EventLoop::cancelTimer(TimerQueue::TimerId timerId) {
+    LOG(debug, "timerId={}", timerId);
+
+    CHECK(isInLoopThread());
+
+    timers_.cancel(timerId);
+}
+
+void EventLoop::runTimers() {
+    LOG(debug, "");
+
+    uint64_t value;
+    if (read(timerFd_, &value, sizeof(value)) < 0) {
+        LOG(debug, "read: errno={}", strerrorname_np(errno));
+        CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+    }
+
+    timerFdExpiry_ = TimerQueue::Clock::time_point::max();
+
+    TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+
+    while (!timers_.empty() && timers_.nextExpiry() <= now) {
+        TimedTask timedTask = timers_.pop();
+
+        state_ = State::kTimedTask;
+
+        uint64_t start = readCycles();
+        timedTask();
+
+        ++stats_.timedTasks;
+        stats_.timedTaskTime += cyclesToNanoseconds(readCycles() - start);
+
+        state_ = State::kIdle;
+    }
+
+    if (!timers_.empty() && timers_.nextExpiry() < timerFdExpiry_) {
+        setTimerFd(timers_.nextExpiry());
+    }
+}
+
+void EventLoop::setTimerFd(TimerQueue::Clock::time_point expiry) {
+    LOG(debug, "");
+
+    std::chrono::nanoseconds time = expiry.time_since_epoch();
+
+    itimerspec newValue{};
+    newValue.it_value.tv_sec = time.count() / 1'000'000'000;
+    newValue.it_value.tv_nsec = time.count() % 1'000'000'000;
+
+    CHECK(timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &newValue, nullptr) == 0);
+
+    timerFdExpiry_ = expiry;
+}
+
+void EventLoop::scheduleStatsDump() {
+    statsDumpTimerId_ = addTimer(TimerQueue::Clock::now() + statsDumpInterval_, [this] {
+        dumpStats();
+        scheduleStatsDump();
+    });
+}
+
+void EventLoop::dumpStats() {
+    LOG(info,
+        "iterations={}, wakeUps={}, events={}, callbacks={}, tasks={}, taskOverflows={}, timedTasks={}, "
+        "watcherUpdates={}, pollerUpdates={}, flushes={}, callbackTime={}, taskTime={}, timedTaskTime={}",
+        stats_.iterations,
+        stats_.wakeUps,
+        stats_.events,
+        stats_.callbacks,
+        stats_.tasks,
+        stats_.taskOverflows,
+        stats_.timedTasks,
+        stats_.watcherUpdates,
+        stats_.pollerUpdates,
+        stats_.flushes,
+        stats_.callbackTime,
+        stats_.taskTime,
+        stats_.timedTaskTime);
+
+    LOG(info,
+        "eventsPerIteration: mean={}, max={}; tasksPerIteration: mean={}, max={}",
+        stats_.eventsPerIteration.mean(),
+        stats_.eventsPerIteration.max(),
+        stats_.tasksPerIteration.mean(),
+        stats_.tasksPerIteration.max());
+
+    LOG(info,
+        "iterationLatency: p50={}ns, p99={}ns, max={}ns; callbackLatency: p50={}ns, p99={}ns, max={}ns",
+        stats_.iterationLatency.percentile(50),
+        stats_.iterationLatency.percentile(99),
+        stats_.iterationLatency.max(),
+        stats_.callbackLatency.percentile(50),
+        stats_.callbackLatency.percentile(99),
+        stats_.callbackLatency.max());
+
+    LOG(info,
+        "longestCallback={}, tag={}, fd={}",
+        stats_.longestCallback,
+        stats_.longestCallbackTag,
+        stats_.longestCallbackFd);
+
+    LOG(info,
+        "bufferPool: pooledBytes={}, inUseBytes={}, allocations={}, hits={}, evictions={}",
+        bufferPool_.stats().pooledBytes,
+        bufferPool_.stats().inUseBytes,
+        bufferPool_.stats().allocations,
+        bufferPool_.stats().hits,
+        bufferPool_.stats().evictions);
+}
+
 EventLoop *mq::EventLoop::background() {
+    return background(kDefaultBackend);
+}
+
+EventLoop *mq::EventLoop::background(Poller::Backend backend) {
     std::promise<EventLoop *> promise;
     std::future<EventLoop *> future = promise.get_future();
 
-    std::thread([promise = std::move(promise)] mutable {
-        EventLoop loop;
+    std::thread([promise = std::move(promise), backend] mutable {
+        EventLoop loop(backend);
         promise.set_value(&loop);
         loop.run();
     }).detach();
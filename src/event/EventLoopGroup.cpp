@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/event/EventLoopGroup.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "mq/event/EventLoop.h"
+#include "mq/utils/Check.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "EventLoopGroup"
+
+using namespace mq;
+
+EventLoopGroup::EventLoopGroup(size_t numLoops, bool pinned) {
+    LOG(debug, "numLoops={}, pinned={}", numLoops, pinned);
+
+    CHECK(numLoops > 0);
+
+    std::vector<int> cpus;
+
+    if (pinned) {
+        cpu_set_t cpuSet;
+        CHECK(sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0);
+
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpuSet)) {
+                cpus.emplace_back(cpu);
+            }
+        }
+
+        CHECK(!cpus.empty());
+    }
+
+    loops_.reserve(numLoops);
+
+    if (pinned) {
+        cpus_.reserve(numLoops);
+    }
+
+    for (size_t i = 0; i < numLoops; ++i) {
+        EventLoop *loop = EventLoop::background();
+
+        if (pinned) {
+            int cpu = cpus[i % cpus.size()];
+
+            bool success;
+
+            loop->postAndWait([cpu, &success] {
+                cpu_set_t cpuSet;
+                CPU_ZERO(&cpuSet);
+                CPU_SET(cpu, &cpuSet);
+
+                int error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+
+                if (error) {
+                    LOG(warning, "pthread_setaffinity_np: error={}", strerrorname_np(error));
+                }
+
+                success = error == 0;
+            });
+
+            LOG(debug, "loop={}, cpu={}, success={}", i, cpu, success);
+
+            cpus_.emplace_back(success ? cpu : -1);
+        }
+
+        loops_.emplace_back(loop);
+    }
+}
+
+EventLoop *EventLoopGroup::next() {
+    return loops_[next_.fetch_add(1, std::memory_order_relaxed) % loops_.size()];
+}
@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/event/IoUringPoller.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mq/utils/Check.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "IoUringPoller"
+
+using namespace mq;
+
+namespace {
+
+constexpr unsigned kEntries = 1024;
+constexpr uint64_t kRemoveUserData = UINT64_MAX;
+
+uint64_t makeUserData(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+} // namespace
+
+IoUringPoller::~IoUringPoller() {
+    LOG(debug, "");
+
+    CHECK(munmap(sqes_, sqesSize_) == 0);
+    CHECK(munmap(ring_, ringSize_) == 0);
+    CHECK(close(ringFd_) == 0);
+}
+
+void IoUringPoller::add(int fd, uint32_t events, uint64_t data) {
+    Entry &entry = this->entry(fd);
+
+    CHECK(!entry.registered);
+
+    entry.data = data;
+    entry.events = events;
+    entry.registered = true;
+
+    arm(fd);
+}
+
+void IoUringPoller::modify(int fd, uint32_t events, uint64_t data) {
+    Entry &entry = this->entry(fd);
+
+    CHECK(entry.registered);
+
+    entry.data = data;
+
+    if (entry.events == events && (entry.armed || entry.pending)) return;
+
+    entry.events = events;
+
+    disarm(fd);
+    arm(fd);
+}
+
+void IoUringPoller::remove(int fd) {
+    Entry &entry = this->entry(fd);
+
+    CHECK(entry.registered);
+
+    disarm(fd);
+
+    entry.events = 0;
+    entry.registered = false;
+}
+
+int IoUringPoller::wait(Event *events, int maxEvents, int timeout) {
+    for (int fd : pending_) {
+        Entry &entry = entries_[fd];
+        entry.pending = false;
+
+        if (!entry.registered || entry.armed || entry.events == 0) continue;
+
+        ++entry.generation;
+        entry.armed = true;
+
+        io_uring_sqe *sqe = nextSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = entry.events;
+        sqe->user_data = makeUserData(fd, entry.generation);
+    }
+
+    pending_.clear();
+
+    bool ready = std::atomic_ref(*cqHead_).load(std::memory_order_relaxed) !=
+                 std::atomic_ref(*cqTail_).load(std::memory_order_acquire);
+
+    if (enter(ready || timeout == 0 ? 0 : 1, timeout) < 0) {
+        int error = errno;
+        LOG(debug, "io_uring_enter: errno={}", strerrorname_np(error));
+
+        if (error != ETIME && error != EBUSY) {
+            CHECK(error == EINTR);
+            errno = error;
+            return -1;
+        }
+    }
+
+    unsigned head = std::atomic_ref(*cqHead_).load(std::memory_order_relaxed);
+    unsigned tail = std::atomic_ref(*cqTail_).load(std::memory_order_acquire);
+
+    int n = 0;
+
+    for (; head != tail && n < maxEvents; ++head) {
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+
+        if (cqe.user_data == kRemoveUserData) continue;
+
+        int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+        uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+
+        Entry &entry = entries_[fd];
+
+        if (!entry.armed || entry.generation != generation) continue;
+
+        entry.armed = false;
+
+        events[n].data = entry.data;
+
+        // A failed poll is reported as an error and stays disarmed until the fd is modified, so that a
+        // closed fd does not complete again on every iteration.
+        if (cqe.res < 0) {
+            LOG(debug, "fd={}, res={}", fd, strerrorname_np(-cqe.res));
+
+            events[n].events = EPOLLERR;
+            ++n;
+            continue;
+        }
+
+        events[n].events = static_cast<uint32_t>(cqe.res);
+        ++n;
+
+        arm(fd);
+    }
+
+    std::atomic_ref(*cqHead_).store(head, std::memory_order_release);
+
+    LOG(debug, "n={}", n);
+
+    return n;
+}
+
+std::unique_ptr<IoUringPoller> IoUringPoller::create() {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+
+    int ringFd = static_cast<int>(syscall(SYS_io_uring_setup, kEntries, &params));
+
+    if (ringFd < 0) {
+        LOG(warning, "io_uring_setup: errno={}", strerrorname_np(errno));
+        return nullptr;
+    }
+
+    constexpr uint32_t kRequiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+
+    if ((params.features & kRequiredFeatures) != kRequiredFeatures) {
+        LOG(warning, "io_uring: features={:#x}", params.features);
+        CHECK(close(ringFd) == 0);
+        return nullptr;
+    }
+
+    size_t ringSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void *ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_SQ_RING);
+    CHECK(ring != MAP_FAILED);
+
+    size_t sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_SQES);
+    CHECK(sqes != MAP_FAILED);
+
+    std::unique_ptr<IoUringPoller> poller(new IoUringPoller);
+
+    char *base = static_cast<char *>(ring);
+
+    poller->ringFd_ = ringFd;
+    poller->ring_ = ring;
+    poller->ringSize_ = ringSize;
+    poller->sqes_ = static_cast<io_uring_sqe *>(sqes);
+    poller->sqesSize_ = sqesSize;
+    poller->sqHead_ = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+    poller->sqTail_ = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    poller->sqMask_ = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    poller->sqEntries_ = params.sq_entries;
+    poller->cqHead_ = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    poller->cqTail_ = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    poller->cqMask_ = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    poller->cqes_ = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+
+    unsigned *sqArray = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; ++i) {
+        sqArray[i] = i;
+    }
+
+    LOG(debug, "ringFd={}, sqEntries={}, cqEntries={}", ringFd, params.sq_entries, params.cq_entries);
+
+    return poller;
+}
+
+IoUringPoller::Entry &IoUringPoller::entry(int fd) {
+    CHECK(fd >= 0);
+
+    if (static_cast<size_t>(fd) >= entries_.size()) {
+        entries_.resize(fd + 1);
+    }
+
+    return entries_[fd];
+}
+
+void IoUringPoller::arm(int fd) {
+    Entry &entry = entries_[fd];
+
+    if (entry.pending) return;
+
+    entry.pending = true;
+    pending_.emplace_back(fd);
+}
+
+void IoUringPoller::disarm(int fd) {
+    Entry &entry = entries_[fd];
+
+    if (!entry.armed) return;
+
+    entry.armed = false;
+
+    io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, entry.generation);
+    sqe->user_data = kRemoveUserData;
+}
+
+io_uring_sqe *IoUringPoller::nextSqe() {
+    unsigned tail = *sqTail_;
+
+    if (tail - std::atomic_ref(*sqHead_).load(std::memory_order_acquire) == sqEntries_) {
+        CHECK(enter(0, 0) >= 0);
+    }
+
+    io_uring_sqe *sqe = &sqes_[tail & sqMask_];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+    std::atomic_ref(*sqTail_).store(tail + 1, std::memory_order_release);
+
+    return sqe;
+}
+
+int IoUringPoller::enter(unsigned minComplete, int timeout) {
+    unsigned toSubmit = std::atomic_ref(*sqTail_).load(std::memory_order_relaxed) -
+                        std::atomic_ref(*sqHead_).load(std::memory_order_acquire);
+
+    if (toSubmit == 0 && minComplete == 0) return 0;
+
+    unsigned flags = 0;
+    io_uring_getevents_arg arg{};
+    __kernel_timespec ts{};
+
+    if (minComplete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+
+        if (timeout >= 0) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = static_cast<long long>(timeout % 1000) * 1'000'000;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+            flags |= IORING_ENTER_EXT_ARG;
+        }
+    }
+
+    int ret = static_cast<int>(syscall(SYS_io_uring_enter, ringFd_, toSubmit, minComplete, flags,
+                                       flags & IORING_ENTER_EXT_ARG ? &arg : nullptr,
+                                       flags & IORING_ENTER_EXT_ARG ? sizeof(arg) : 0));
+
+    LOG(debug, "io_uring_enter: toSubmit={}, minComplete={}, ret={}", toSubmit, minComplete, ret);
+
+    return ret;
+}
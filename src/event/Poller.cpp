@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/event/Poller.h"
+
+#include <memory>
+
+#include "mq/event/EpollPoller.h"
+#include "mq/event/IoUringPoller.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "Poller"
+
+using namespace mq;
+
+std::unique_ptr<Poller> Poller::create(Backend backend) {
+    LOG(debug, "backend={}", backend);
+
+    if (backend == Backend::kIoUring) {
+        std::unique_ptr<IoUringPoller> poller = IoUringPoller::create();
+
+        if (poller) return poller;
+
+        LOG(warning, "io_uring unavailable, falling back to epoll");
+    }
+
+    return std::make_unique<EpollPoller>();
+}
@@ -3,15 +3,10 @@
 #include "mq/event/Timer.h"
 
 #include <chrono>
-#include <cstdint>
-#include <memory>
 #include <utility>
-#include <vector>
-
-#include <sys/timerfd.h>
 
 #include "mq/event/EventLoop.h"
-#include "mq/event/Watcher.h"
+#include "mq/event/TimerQueue.h"
 #include "mq/utils/Check.h"
 #include "mq/utils/Logging.h"
 
@@ -41,7 +36,7 @@ bool Timer::hasExpireCallback() const {
 void Timer::addExpireCallback(ExpireCallback expireCallback) {
     CHECK(loop_->isInLoopThread());
 
-    expireCallbacks_.emplace_back(std::move(expireCallback));
+    expireCallbacks_.add(std::move(expireCallback));
 }
 
 void Timer::clearExpireCallbacks() {
@@ -55,14 +50,7 @@ void Timer::dispatchExpire() {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<ExpireCallback> expireCallbacks = std::move(expireCallbacks_);
-    expireCallbacks_.clear();
-
-    for (ExpireCallback &expireCallback : expireCallbacks) {
-        if (expireCallback()) {
-            expireCallbacks_.emplace_back(std::move(expireCallback));
-        }
-    }
+    expireCallbacks_.dispatch();
 }
 
 Timer::State Timer::state() const {
@@ -71,39 +59,12 @@ Timer::State Timer::state() const {
     return state_;
 }
 
-int Timer::fd() const {
-    CHECK(loop_->isInLoopThread());
-    CHECK(state_ == State::kOpened);
-
-    return fd_;
-}
-
-Watcher &Timer::watcher() {
-    CHECK(loop_->isInLoopThread());
-    CHECK(state_ == State::kOpened);
-
-    return *watcher_;
-}
-
-const Watcher &Timer::watcher() const {
-    CHECK(loop_->isInLoopThread());
-    CHECK(state_ == State::kOpened);
-
-    return *watcher_;
-}
-
 void Timer::open() {
     LOG(debug, "");
 
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kClosed);
 
-    CHECK((fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) >= 0);
-
-    watcher_ = std::make_unique<Watcher>(loop_, fd_);
-    watcher_->registerSelf();
-    watcher_->addReadReadyCallback([this] { return onWatcherReadReady(); });
-
     State oldState = state_;
     state_ = State::kOpened;
     LOG(debug, "{} -> {}", oldState, state_);
@@ -114,11 +75,9 @@ void Timer::setTime(std::chrono::nanoseconds delay) {
     CHECK(state_ == State::kOpened);
     CHECK(delay.count() > 0);
 
-    itimerspec newValue{};
-    newValue.it_value.tv_sec = delay.count() / 1'000'000'000;
-    newValue.it_value.tv_nsec = delay.count() % 1'000'000'000;
+    interval_ = std::chrono::nanoseconds();
 
-    CHECK(timerfd_settime(fd_, 0, &newValue, nullptr) == 0);
+    schedule(TimerQueue::Clock::now() + delay);
 }
 
 void Timer::setTime(std::chrono::nanoseconds delay, std::chrono::nanoseconds interval) {
@@ -127,21 +86,19 @@ void Timer::setTime(std::chrono::nanoseconds delay, std::chrono::nanoseconds int
     CHECK(delay.count() > 0);
     CHECK(interval.count() > 0);
 
-    itimerspec newValue{};
-    newValue.it_value.tv_sec = delay.count() / 1'000'000'000;
-    newValue.it_value.tv_nsec = delay.count() % 1'000'000'000;
-    newValue.it_interval.tv_sec = interval.count() / 1'000'000'000;
-    newValue.it_interval.tv_nsec = interval.count() % 1'000'000'000;
+    interval_ = interval;
 
-    CHECK(timerfd_settime(fd_, 0, &newValue, nullptr) == 0);
+    schedule(TimerQueue::Clock::now() + delay);
 }
 
 void Timer::cancel() {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kOpened);
 
-    itimerspec newValue{};
-    CHECK(timerfd_settime(fd_, 0, &newValue, nullptr) == 0);
+    if (timerId_ != 0) {
+        loop_->cancelTimer(timerId_);
+        timerId_ = 0;
+    }
 }
 
 void Timer::close() {
@@ -151,19 +108,11 @@ void Timer::close() {
 
     if (state_ == State::kClosed) return;
 
+    cancel();
+
     State oldState = state_;
     state_ = State::kClosed;
     LOG(debug, "{} -> {}", oldState, state_);
-
-    watcher_->clearReadReadyCallbacks();
-
-    loop_->post([watcher = std::move(watcher_), fd = fd_] {
-        watcher->unregisterSelf();
-
-        CHECK(::close(fd) == 0);
-    });
-
-    watcher_ = nullptr;
 }
 
 void Timer::reset() {
@@ -175,28 +124,38 @@ void Timer::reset() {
 
     if (state_ == State::kClosed) return;
 
+    cancel();
+
     State oldState = state_;
     state_ = State::kClosed;
     LOG(debug, "{} -> {}", oldState, state_);
+}
 
-    watcher_->clearReadReadyCallbacks();
-
-    loop_->post([watcher = std::move(watcher_), fd = fd_] {
-        watcher->unregisterSelf();
-
-        CHECK(::close(fd) == 0);
-    });
+void Timer::schedule(TimerQueue::Clock::time_point expiry) {
+    if (timerId_ != 0) {
+        loop_->cancelTimer(timerId_);
+    }
 
-    watcher_ = nullptr;
+    expiry_ = expiry;
+    timerId_ = loop_->addTimer(expiry_, [this] { onExpire(); });
 }
 
-bool Timer::onWatcherReadReady() {
+void Timer::onExpire() {
     LOG(debug, "");
 
-    uint64_t value;
-    CHECK(read(fd_, &value, sizeof(value)) == sizeof(value));
+    timerId_ = 0;
 
     dispatchExpire();
 
-    return true;
+    if (state_ == State::kOpened && timerId_ == 0 && interval_.count() > 0) {
+        TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+
+        expiry_ += interval_;
+
+        if (expiry_ <= now) {
+            expiry_ += ((now - expiry_) / interval_ + 1) * interval_;
+        }
+
+        schedule(expiry_);
+    }
 }
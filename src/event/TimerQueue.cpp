@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/event/TimerQueue.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "mq/utils/Check.h"
+#include "mq/utils/Logging.h"
+
+#define TAG "TimerQueue"
+
+using namespace mq;
+
+namespace {
+
+constexpr size_t kArity = 4;
+
+} // namespace
+
+TimerQueue::Clock::time_point TimerQueue::nextExpiry() const {
+    CHECK(!heap_.empty());
+
+    return heap_.front().expiry;
+}
+
+bool TimerQueue::contains(TimerId id) const {
+    uint32_t slot = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+
+    return slot < slots_.size() && slots_[slot].generation == generation && slots_[slot].callback;
+}
+
+TimerQueue::TimerId TimerQueue::add(Clock::time_point expiry, Callback callback) {
+    CHECK(callback);
+
+    uint32_t slot;
+
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+
+    slots_[slot].callback = std::move(callback);
+
+    heap_.emplace_back();
+    place(heap_.size() - 1, Node{expiry, nextSequence_++, slot});
+    siftUp(heap_.size() - 1);
+
+    return (static_cast<uint64_t>(slots_[slot].generation) << 32) | slot;
+}
+
+bool TimerQueue::cancel(TimerId id) {
+    if (!contains(id)) return false;
+
+    removeAt(slots_[static_cast<uint32_t>(id)].index);
+
+    return true;
+}
+
+TimerQueue::Callback TimerQueue::pop() {
+    CHECK(!heap_.empty());
+
+    return removeAt(0);
+}
+
+void TimerQueue::place(size_t i, Node node) {
+    slots_[node.slot].index = i;
+    heap_[i] = node;
+}
+
+void TimerQueue::siftUp(size_t i) {
+    Node node = heap_[i];
+
+    while (i > 0) {
+        size_t parent = (i - 1) / kArity;
+
+        if (!less(node, heap_[parent])) break;
+
+        place(i, heap_[parent]);
+        i = parent;
+    }
+
+    place(i, node);
+}
+
+void TimerQueue::siftDown(size_t i) {
+    Node node = heap_[i];
+    size_t size = heap_.size();
+
+    for (;;) {
+        size_t first = i * kArity + 1;
+
+        if (first >= size) break;
+
+        size_t last = std::min(first + kArity, size);
+        size_t min = first;
+
+        for (size_t j = first + 1; j < last; ++j) {
+            if (less(heap_[j], heap_[min])) {
+                min = j;
+            }
+        }
+
+        if (!less(heap_[min], node)) break;
+
+        place(i, heap_[min]);
+        i = min;
+    }
+
+    place(i, node);
+}
+
+TimerQueue::Callback TimerQueue::removeAt(size_t i) {
+    uint32_t slot = heap_[i].slot;
+
+    Callback callback = std::move(slots_[slot].callback);
+    slots_[slot].callback = nullptr;
+    ++slots_[slot].generation;
+    freeSlots_.push_back(slot);
+
+    Node last = heap_.back();
+    heap_.pop_back();
+
+    if (i < heap_.size()) {
+        place(i, last);
+
+        if (i > 0 && less(last, heap_[(i - 1) / kArity])) {
+            siftUp(i);
+        } else {
+            siftDown(i);
+        }
+    }
+
+    return callback;
+}
@@ -2,8 +2,10 @@
 
 #include "mq/event/Watcher.h"
 
+#include <string>
 #include <utility>
-#include <vector>
+
+#include <sys/epoll.h>
 
 #include "mq/event/EventLoop.h"
 #include "mq/utils/Check.h"
@@ -24,6 +26,19 @@ Watcher::~Watcher() {
     CHECK(!loop_->hasWatcher(fd_));
 }
 
+void Watcher::setTag(std::string tag) {
+    CHECK(loop_->isInLoopThread());
+
+    tag_ = std::move(tag);
+}
+
+void Watcher::setEdgeTriggered(bool edgeTriggered) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(!loop_->hasWatcher(fd_));
+
+    edgeTriggered_ = edgeTriggered;
+}
+
 bool Watcher::hasReadReadyCallback() const {
     CHECK(loop_->isInLoopThread());
 
@@ -36,10 +51,22 @@ bool Watcher::hasWriteReadyCallback() const {
     return !writeReadyCallbacks_.empty();
 }
 
+bool Watcher::hasFlushCallback() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !flushCallbacks_.empty();
+}
+
+bool Watcher::hasErrorCallback() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !errorCallbacks_.empty();
+}
+
 void Watcher::addReadReadyCallback(ReadReadyCallback readReadyCallback) {
     CHECK(loop_->isInLoopThread());
 
-    readReadyCallbacks_.emplace_back(std::move(readReadyCallback));
+    readReadyCallbacks_.add(std::move(readReadyCallback));
 
     if (readReadyCallbacks_.size() == 1) {
         loop_->updateWatcherIfRegistered(this);
@@ -49,13 +76,25 @@ void Watcher::addReadReadyCallback(ReadReadyCallback readReadyCallback) {
 void Watcher::addWriteReadyCallback(WriteReadyCallback writeReadyCallback) {
     CHECK(loop_->isInLoopThread());
 
-    writeReadyCallbacks_.emplace_back(std::move(writeReadyCallback));
+    writeReadyCallbacks_.add(std::move(writeReadyCallback));
 
     if (writeReadyCallbacks_.size() == 1) {
         loop_->updateWatcherIfRegistered(this);
     }
 }
 
+void Watcher::addFlushCallback(FlushCallback flushCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    flushCallbacks_.add(std::move(flushCallback));
+}
+
+void Watcher::addErrorCallback(ErrorCallback errorCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    errorCallbacks_.add(std::move(errorCallback));
+}
+
 void Watcher::clearReadReadyCallbacks() {
     CHECK(loop_->isInLoopThread());
 
@@ -76,19 +115,24 @@ void Watcher::clearWriteReadyCallbacks() {
     }
 }
 
+void Watcher::clearFlushCallbacks() {
+    CHECK(loop_->isInLoopThread());
+
+    flushCallbacks_.clear();
+}
+
+void Watcher::clearErrorCallbacks() {
+    CHECK(loop_->isInLoopThread());
+
+    errorCallbacks_.clear();
+}
+
 void Watcher::dispatchReadReady() {
     LOG(debug, "");
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<ReadReadyCallback> readReadyCallbacks(std::move(readReadyCallbacks_));
-    readReadyCallbacks_.clear();
-
-    for (ReadReadyCallback &readReadyCallback : readReadyCallbacks) {
-        if (readReadyCallback()) {
-            readReadyCallbacks_.emplace_back(std::move(readReadyCallback));
-        }
-    }
+    readReadyCallbacks_.dispatch();
 }
 
 void Watcher::dispatchWriteReady() {
@@ -96,14 +140,41 @@ void Watcher::dispatchWriteReady() {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<WriteReadyCallback> writeReadyCallbacks(std::move(writeReadyCallbacks_));
-    writeReadyCallbacks_.clear();
+    writeReadyCallbacks_.dispatch();
+}
 
-    for (WriteReadyCallback &writeReadyCallback : writeReadyCallbacks) {
-        if (writeReadyCallback()) {
-            writeReadyCallbacks_.emplace_back(std::move(writeReadyCallback));
-        }
-    }
+void Watcher::dispatchFlush() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    flushCallbacks_.dispatch();
+}
+
+void Watcher::dispatchError() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    errorCallbacks_.dispatch();
+}
+
+void Watcher::clearReadReady() {
+    CHECK(loop_->isInLoopThread());
+
+    loop_->clearWatcherReady(this, EPOLLIN);
+}
+
+void Watcher::clearWriteReady() {
+    CHECK(loop_->isInLoopThread());
+
+    loop_->clearWatcherReady(this, EPOLLOUT);
+}
+
+void Watcher::scheduleFlush() {
+    CHECK(loop_->isInLoopThread());
+
+    loop_->scheduleWatcherFlush(this);
 }
 
 void Watcher::registerSelf() {
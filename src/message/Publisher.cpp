@@ -2,17 +2,23 @@
 
 #include "mq/message/Publisher.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <cerrno>
+#include <cstdint>
 #include <cstring>
-#include <iterator>
+#include <future>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
+#include "mq/message/Subscription.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingAcceptor.h"
 #include "mq/net/FramingSocket.h"
@@ -21,11 +27,18 @@
 #include "mq/utils/Empty.h"
 #include "mq/utils/Logging.h"
 #include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SharedBuffer.h"
 
 #define TAG "Publisher"
 
 using namespace mq;
 
+namespace {
+
+constexpr std::chrono::milliseconds kSnapshotGracePeriod(100);
+
+} // namespace
+
 Publisher::Publisher(EventLoop *loop, const Endpoint &localEndpoint)
     : loop_(loop), localEndpoint_(localEndpoint.clone()) {
     LOG(debug, "");
@@ -164,6 +177,174 @@ void Publisher::setKeepAlive(KeepAlive keepAlive) {
     }
 }
 
+void Publisher::setHighWatermark(size_t highWatermark) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        highWatermark_ = highWatermark;
+    } else {
+        loop_->postAndWait([this, highWatermark] {
+            CHECK(state_ == State::kClosed);
+
+            highWatermark_ = highWatermark;
+        });
+    }
+}
+
+void Publisher::setLowWatermark(size_t lowWatermark) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        lowWatermark_ = lowWatermark;
+    } else {
+        loop_->postAndWait([this, lowWatermark] {
+            CHECK(state_ == State::kClosed);
+
+            lowWatermark_ = lowWatermark;
+        });
+    }
+}
+
+void Publisher::setSlowSubscriberPolicy(SlowSubscriberPolicy slowSubscriberPolicy) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        slowSubscriberPolicy_ = slowSubscriberPolicy;
+    } else {
+        loop_->postAndWait([this, slowSubscriberPolicy] {
+            CHECK(state_ == State::kClosed);
+
+            slowSubscriberPolicy_ = slowSubscriberPolicy;
+        });
+    }
+}
+
+void Publisher::setMaxQueuedMessages(size_t maxQueuedMessages) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxQueuedMessages_ = maxQueuedMessages;
+    } else {
+        loop_->postAndWait([this, maxQueuedMessages] {
+            CHECK(state_ == State::kClosed);
+
+            maxQueuedMessages_ = maxQueuedMessages;
+        });
+    }
+}
+
+void Publisher::setMaxQueuedBytes(size_t maxQueuedBytes) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxQueuedBytes_ = maxQueuedBytes;
+    } else {
+        loop_->postAndWait([this, maxQueuedBytes] {
+            CHECK(state_ == State::kClosed);
+
+            maxQueuedBytes_ = maxQueuedBytes;
+        });
+    }
+}
+
+void Publisher::setMaxLag(std::chrono::nanoseconds maxLag) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxLag_ = maxLag;
+    } else {
+        loop_->postAndWait([this, maxLag] {
+            CHECK(state_ == State::kClosed);
+
+            maxLag_ = maxLag;
+        });
+    }
+}
+
+void Publisher::setLastValueCacheCapacity(size_t lastValueCacheCapacity) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        lastValueCacheCapacity_ = lastValueCacheCapacity;
+    } else {
+        loop_->postAndWait([this, lastValueCacheCapacity] {
+            CHECK(state_ == State::kClosed);
+
+            lastValueCacheCapacity_ = lastValueCacheCapacity;
+        });
+    }
+}
+
+void Publisher::setSequenced(bool sequenced) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        sequenced_ = sequenced;
+    } else {
+        loop_->postAndWait([this, sequenced] {
+            CHECK(state_ == State::kClosed);
+
+            sequenced_ = sequenced;
+        });
+    }
+}
+
+void Publisher::setMaxSequencedTopics(size_t maxSequencedTopics) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxSequencedTopics_ = maxSequencedTopics;
+    } else {
+        loop_->postAndWait([this, maxSequencedTopics] {
+            CHECK(state_ == State::kClosed);
+
+            maxSequencedTopics_ = maxSequencedTopics;
+        });
+    }
+}
+
+void Publisher::setWorkerGroup(EventLoopGroup *workerGroup) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        workerGroup_ = workerGroup;
+    } else {
+        loop_->postAndWait([this, workerGroup] {
+            CHECK(state_ == State::kClosed);
+
+            workerGroup_ = workerGroup;
+        });
+    }
+}
+
+void Publisher::setSharded(bool sharded) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        sharded_ = sharded;
+    } else {
+        loop_->postAndWait([this, sharded] {
+            CHECK(state_ == State::kClosed);
+
+            sharded_ = sharded;
+        });
+    }
+}
+
+void Publisher::setCpuSteering(bool cpuSteering) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        cpuSteering_ = cpuSteering;
+    } else {
+        loop_->postAndWait([this, cpuSteering] {
+            CHECK(state_ == State::kClosed);
+
+            cpuSteering_ = cpuSteering;
+        });
+    }
+}
+
 int Publisher::open() {
     LOG(debug, "");
 
@@ -171,6 +352,22 @@ int Publisher::open() {
 
     if (loop_->isInLoopThread()) {
         CHECK(state_ == State::kClosed);
+        CHECK(slowSubscriberPolicy_ != SlowSubscriberPolicy::kNone || lastValueCacheCapacity_ <= sendBufferMaxCapacity_);
+
+        if (!workerGroup_) {
+            shards_.emplace_back(std::make_shared<Shard>(loop_, maxConnections_));
+        } else {
+            size_t numWorkers = workerGroup_->size();
+            size_t maxConnections = (maxConnections_ + numWorkers - 1) / numWorkers;
+
+            for (EventLoop *worker : workerGroup_->loops()) {
+                shards_.emplace_back(std::make_shared<Shard>(worker, maxConnections));
+            }
+        }
+
+        for (const std::shared_ptr<Shard> &shard : shards_) {
+            shard->token = std::make_shared<Empty>();
+        }
 
         acceptor_ = std::make_unique<FramingAcceptor>(loop_);
 
@@ -184,16 +381,46 @@ int Publisher::open() {
         acceptor_->setReusePort(reusePort_);
         acceptor_->setNoDelay(noDelay_);
         acceptor_->setKeepAlive(keepAlive_);
+        acceptor_->setHighWatermark(highWatermark_);
+        acceptor_->setLowWatermark(lowWatermark_);
 
-        acceptor_->addAcceptCallback([this](std::unique_ptr<FramingSocket> socket, const Endpoint &) {
-            return onFramingAcceptorAccept(std::move(socket));
-        });
+        if (!workerGroup_) {
+            acceptor_->addAcceptCallback([this](std::unique_ptr<FramingSocket> socket, const Endpoint &) {
+                return onFramingAcceptorAccept(shards_.front().get(), std::move(socket));
+            });
+        } else {
+            acceptor_->setWorkerGroup(workerGroup_);
+            acceptor_->setSharded(sharded_);
+            acceptor_->setCpuSteering(cpuSteering_);
+            acceptor_->setWorkerAcceptCallback([this, shards = shards_](std::unique_ptr<FramingSocket> socket,
+                                                                        const Endpoint &) {
+                for (const std::shared_ptr<Shard> &shard : shards) {
+                    if (shard->loop == socket->loop()) {
+                        if (!shard->token) {
+                            socket->reset();
+
+                            shard->loop->post([socket = std::move(socket)] {});
+
+                            return;
+                        }
+
+                        onFramingAcceptorAccept(shard.get(), std::move(socket));
+
+                        return;
+                    }
+                }
+
+                std::unreachable();
+            });
+        }
 
         error = acceptor_->open(*localEndpoint_);
         if (error) {
             loop_->post([acceptor = std::move(acceptor_)] {});
 
             acceptor_ = nullptr;
+
+            shards_.clear();
         } else {
             token_ = std::make_shared<Empty>();
 
@@ -210,51 +437,129 @@ int Publisher::open() {
     return error;
 }
 
-void Publisher::send(MaybeOwnedString message) {
-    LOG(debug, "");
+bool Publisher::writable() const {
+    bool writable;
 
     if (loop_->isInLoopThread()) {
-        for (const std::shared_ptr<FramingSocket> &socket : sockets_) {
-            if (int error = socket->send(message)) {
-                LOG(warning, "send: error={}", strerrorname_np(error));
-            }
+        writable = numBlockedSockets_ == 0;
+    } else {
+        loop_->postAndWait([this, &writable] {
+            writable = numBlockedSockets_ == 0;
+        });
+    }
+
+    return writable;
+}
+
+int Publisher::waitForWritable(std::chrono::nanoseconds timeout) {
+    CHECK(!loop_->isInLoopThread());
+
+    std::shared_future<void> future;
+
+    // Waiters share one promise per blocked episode, so waits that time out leave nothing behind.
+    loop_->postAndWait([this, &future] {
+        if (numBlockedSockets_ == 0) return;
+
+        if (!writablePromise_) {
+            writablePromise_.emplace();
+            writableFuture_ = writablePromise_->get_future().share();
         }
+
+        future = writableFuture_;
+    });
+
+    if (!future.valid()) return 0;
+
+    if (timeout.count() == 0) {
+        future.wait();
     } else {
-        loop_->post([this, message = std::string(std::move(message)), token = std::weak_ptr(token_)] mutable {
-            if (token.expired()) return;
+        if (future.wait_for(timeout) != std::future_status::ready) {
+            return ETIMEDOUT;
+        }
+    }
 
-            send(std::move(message));
-        });
+    return 0;
+}
+
+void Publisher::send(MaybeOwnedString message) {
+    LOG(debug, "");
+
+    if (!sequenced_) {
+        sendFrame(FramingSocket::frame(message));
+    } else {
+        char header[kSequenceHeaderSize];
+        encodeSequenceHeader(header, 0, 0);
+
+        MaybeOwnedString pieces[] = {std::string_view(header, kSequenceHeaderSize), std::move(message)};
+        sendFrame(FramingSocket::frame(pieces));
     }
 }
 
 void Publisher::send(std::vector<MaybeOwnedString> pieces) {
     LOG(debug, "");
 
-    if (loop_->isInLoopThread()) {
-        std::vector<std::string_view> newPieces(std::make_move_iterator(pieces.begin()),
-                                                std::make_move_iterator(pieces.end()));
+    char header[kSequenceHeaderSize];
 
-        for (const std::shared_ptr<FramingSocket> &socket : sockets_) {
-            if (int error = socket->send(newPieces)) {
-                LOG(warning, "send: error={}", strerrorname_np(error));
-            }
-        }
+    if (sequenced_) {
+        encodeSequenceHeader(header, 0, 0);
+
+        pieces.emplace(pieces.begin(), std::string_view(header, kSequenceHeaderSize));
+    }
+
+    sendFrame(FramingSocket::frame(pieces));
+}
+
+void Publisher::send(std::string_view topic, MaybeOwnedString message) {
+    LOG(debug, "topic={}", topic);
+
+    if (!sequenced_) {
+        sendFrame(FramingSocket::frame(message), SharedBuffer(topic));
     } else {
-        if (!sockets_.empty()) {
-            std::vector<MaybeOwnedString> newPieces;
-            newPieces.reserve(pieces.size());
-            for (MaybeOwnedString &piece : pieces) {
-                newPieces.emplace_back(std::string(std::move(piece)));
-            }
+        CHECK(topic.size() <= UINT16_MAX);
 
-            loop_->post([this, newPieces = std::move(newPieces), token = std::weak_ptr(token_)] mutable {
-                if (token.expired()) return;
+        char header[kSequenceHeaderSize];
+        encodeSequenceHeader(header, 0, topic.size());
 
-                send(std::move(newPieces));
-            });
+        MaybeOwnedString pieces[] = {std::string_view(header, kSequenceHeaderSize), topic, std::move(message)};
+        sendFrame(FramingSocket::frame(pieces), SharedBuffer(topic));
+    }
+}
+
+std::vector<Publisher::SubscriberStats> Publisher::subscriberStats() const {
+    std::vector<SubscriberStats> subscriberStats;
+
+    if (loop_->isInLoopThread()) {
+        for (const std::shared_ptr<Shard> &shard : shards_) {
+            auto collect = [shard = shard.get(), &subscriberStats] {
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+                for (const auto &[socket, backlog] : shard->backlogs) {
+                    SubscriberStats &stats = subscriberStats.emplace_back();
+                    stats.remoteEndpoint = socket->remoteEndpoint();
+                    stats.queuedMessages = backlog.frames.size();
+                    stats.queuedBytes = backlog.bytes + socket->socket().sendBufferSize();
+                    stats.droppedMessages = backlog.droppedMessages;
+                    stats.conflatedMessages = backlog.conflatedMessages;
+
+                    if (!backlog.frames.empty()) {
+                        stats.lag = now - backlog.behindSince;
+                    }
+                }
+            };
+
+            if (shard->loop->isInLoopThread()) {
+                collect();
+            } else {
+                shard->loop->postAndWait(collect);
+            }
         }
+    } else {
+        loop_->postAndWait([this, &subscriberStats] {
+            subscriberStats = this->subscriberStats();
+        });
     }
+
+    return subscriberStats;
 }
 
 void Publisher::close() {
@@ -265,17 +570,28 @@ void Publisher::close() {
 
         acceptor_->reset();
 
-        for (const std::shared_ptr<FramingSocket> &socket : sockets_) {
-            socket->reset();
-        }
-
-        loop_->post([acceptor = std::move(acceptor_), sockets = std::move(sockets_)] {});
+        loop_->post([acceptor = std::move(acceptor_)] {});
 
         acceptor_ = nullptr;
-        sockets_.clear();
+
+        for (const std::shared_ptr<Shard> &shard : shards_) {
+            if (shard->loop->isInLoopThread()) {
+                closeShard(shard.get());
+            } else {
+                shard->loop->postAndWait([shard = shard.get()] {
+                    closeShard(shard);
+                });
+            }
+        }
+
+        shards_.clear();
 
         token_ = nullptr;
 
+        numBlockedSockets_ = 0;
+
+        releaseWritableWaiters();
+
         State oldState = state_;
         state_ = State::kClosed;
         LOG(debug, "{} -> {}", oldState, state_);
@@ -286,36 +602,518 @@ void Publisher::close() {
     }
 }
 
-bool Publisher::onFramingAcceptorAccept(std::unique_ptr<FramingSocket> socket) {
+void Publisher::sendFrame(SharedBuffer frame, SharedBuffer topic) {
+    if (loop_->isInLoopThread()) {
+        if (sequenced_ && !topic.empty()) {
+            setSequence(frame.mutableData() + 4, nextSequence(topic));
+        }
+
+        for (const std::shared_ptr<Shard> &shard : shards_) {
+            if (shard->loop->isInLoopThread()) {
+                sendShard(shard.get(), frame, topic);
+            } else {
+                shard->loop->post([this, shard, frame, topic, token = std::weak_ptr(shard->token)] {
+                    if (token.expired()) return;
+
+                    sendShard(shard.get(), frame, topic);
+                });
+            }
+        }
+    } else {
+        loop_->post([this, frame = std::move(frame), topic = std::move(topic), token = std::weak_ptr(token_)] mutable {
+            if (token.expired()) return;
+
+            sendFrame(std::move(frame), std::move(topic));
+        });
+    }
+}
+
+void Publisher::sendShard(Shard *shard, const SharedBuffer &frame, const SharedBuffer &topic) {
+    if (lastValueCacheCapacity_ > 0 && !topic.empty()) {
+        cacheFrame(shard, frame, topic);
+    }
+
+    if (shard->socketToTopics.empty()) {
+        for (const std::shared_ptr<FramingSocket> &socket : shard->sockets) {
+            sendSocket(shard, socket.get(), frame, topic);
+        }
+
+        return;
+    }
+
+    std::string_view message = frameMessage(frame);
+
+    std::vector<FramingSocket *> &matchedSockets = shard->matchedSockets;
+    matchedSockets.assign(shard->unfilteredSockets.begin(), shard->unfilteredSockets.end());
+
+    size_t numUnfilteredSockets = matchedSockets.size();
+
+    shard->topicMatcher.match(message, [&matchedSockets](FramingSocket *socket) {
+        matchedSockets.emplace_back(socket);
+        return true;
+    });
+
+    if (matchedSockets.size() - numUnfilteredSockets > 1) {
+        std::sort(matchedSockets.begin(), matchedSockets.end());
+        matchedSockets.erase(std::unique(matchedSockets.begin(), matchedSockets.end()), matchedSockets.end());
+    }
+
+    for (FramingSocket *socket : matchedSockets) {
+        sendSocket(shard, socket, frame, topic);
+    }
+
+    matchedSockets.clear();
+}
+
+void Publisher::sendSocket(Shard *shard, FramingSocket *socket, const SharedBuffer &frame, const SharedBuffer &topic) {
+    if (!shard->snapshotPending.empty()) {
+        if (auto i = shard->snapshotPending.find(socket); i != shard->snapshotPending.end()) {
+            i->second.emplace_back(frame, topic);
+            return;
+        }
+    }
+
+    if (slowSubscriberPolicy_ != SlowSubscriberPolicy::kNone) {
+        Backlog &backlog = shard->backlogs.find(socket)->second;
+
+        if (!backlog.frames.empty() || socket->socket().sendBufferSize() > 0) {
+            enqueueFrame(shard, socket, backlog, frame, topic);
+            return;
+        }
+    }
+
+    if (int error = socket->sendFrame(frame)) {
+        LOG(warning, "send: error={}", strerrorname_np(error));
+    }
+}
+
+void Publisher::enqueueFrame(Shard *shard,
+                             FramingSocket *socket,
+                             Backlog &backlog,
+                             const SharedBuffer &frame,
+                             const SharedBuffer &topic) {
+    if (backlog.disconnecting) return;
+
+    if (backlog.frames.empty()) {
+        backlog.behindSince = std::chrono::steady_clock::now();
+
+        if (slowSubscriberPolicy_ == SlowSubscriberPolicy::kDisconnect && maxLag_.count() > 0) {
+            shard->loop->postTimed([this,
+                                    shard,
+                                    socket = std::weak_ptr(socket->shared_from_this()),
+                                    behindSince = backlog.behindSince,
+                                    token = std::weak_ptr(shard->token)] {
+                if (token.expired()) return;
+
+                std::shared_ptr<FramingSocket> lockedSocket = socket.lock();
+                if (!lockedSocket) return;
+
+                auto i = shard->backlogs.find(lockedSocket.get());
+                if (i == shard->backlogs.end()) return;
+
+                if (!i->second.frames.empty() && i->second.behindSince == behindSince) {
+                    disconnect(shard, lockedSocket.get(), i->second);
+                }
+            }, maxLag_);
+        }
+    }
+
+    if (slowSubscriberPolicy_ == SlowSubscriberPolicy::kConflate && !topic.empty()) {
+        if (auto i = backlog.topicToId.find(topic); i != backlog.topicToId.end()) {
+            QueuedFrame &queuedFrame = backlog.frames[i->second - backlog.firstId];
+            backlog.bytes -= queuedFrame.frame.size();
+            backlog.bytes += frame.size();
+            queuedFrame.frame = frame;
+            ++backlog.conflatedMessages;
+
+            // A larger replacement can push the backlog over its byte bound, so evict as on append.
+            while (maxQueuedBytes_ > 0 && backlog.bytes > maxQueuedBytes_) {
+                popFrame(backlog);
+                ++backlog.droppedMessages;
+            }
+
+            return;
+        }
+    }
+
+    auto full = [this, &backlog, &frame] {
+        return (maxQueuedMessages_ > 0 && backlog.frames.size() >= maxQueuedMessages_) ||
+               (maxQueuedBytes_ > 0 && backlog.bytes + frame.size() > maxQueuedBytes_);
+    };
+
+    if (full()) {
+        if (slowSubscriberPolicy_ == SlowSubscriberPolicy::kDisconnect) {
+            disconnect(shard, socket, backlog);
+            return;
+        }
+
+        if (slowSubscriberPolicy_ != SlowSubscriberPolicy::kDropNewest) {
+            while (!backlog.frames.empty() && full()) {
+                popFrame(backlog);
+                ++backlog.droppedMessages;
+            }
+        }
+
+        if (full()) {
+            ++backlog.droppedMessages;
+            return;
+        }
+    }
+
+    backlog.frames.emplace_back(frame, topic);
+    backlog.bytes += frame.size();
+
+    if (slowSubscriberPolicy_ == SlowSubscriberPolicy::kConflate && !topic.empty()) {
+        backlog.topicToId.emplace(backlog.frames.back().topic, backlog.firstId + backlog.frames.size() - 1);
+    }
+}
+
+void Publisher::disconnect(Shard *shard, FramingSocket *socket, Backlog &backlog) {
+    LOG(warning, "Disconnecting slow subscriber {}", *socket->remoteEndpoint());
+
+    backlog.disconnecting = true;
+
+    shard->loop->post([socket = std::weak_ptr(socket->shared_from_this())] {
+        if (std::shared_ptr<FramingSocket> lockedSocket = socket.lock()) {
+            lockedSocket->close();
+        }
+    });
+}
+
+void Publisher::popFrame(Backlog &backlog) {
+    QueuedFrame &queuedFrame = backlog.frames.front();
+
+    if (!queuedFrame.topic.empty()) {
+        if (auto i = backlog.topicToId.find(queuedFrame.topic); i != backlog.topicToId.end() && i->second == backlog.firstId) {
+            backlog.topicToId.erase(i);
+        }
+    }
+
+    backlog.bytes -= queuedFrame.frame.size();
+    backlog.frames.pop_front();
+    ++backlog.firstId;
+}
+
+uint64_t Publisher::nextSequence(const SharedBuffer &topic) {
+    if (auto i = topicToSequence_.find(topic); i != topicToSequence_.end()) {
+        topicToSequence_.moveToBack(i);
+
+        return ++i->second.sequence;
+    }
+
+    // Counters are evicted least recently used first. An evicted topic restarts at 1, which subscribers
+    // treat as a publisher restart rather than a gap.
+    if (maxSequencedTopics_ > 0 && topicToSequence_.size() >= maxSequencedTopics_) {
+        topicToSequence_.erase(topicToSequence_.begin());
+    }
+
+    std::string_view key = topic;
+    topicToSequence_.emplace(key, TopicSequence{topic, 1});
+
+    return 1;
+}
+
+void Publisher::cacheFrame(Shard *shard, const SharedBuffer &frame, const SharedBuffer &topic) {
+    LastValueCache &lastValueCache = shard->lastValueCache;
+
+    QueuedFrame cachedFrame(frame, topic);
+
+    if (auto i = lastValueCache.find(topic); i != lastValueCache.end()) {
+        shard->lastValueCacheSize -= i->second.topic.size() + i->second.frame.size();
+        cachedFrame.topic = std::move(i->second.topic);
+        lastValueCache.erase(i);
+    }
+
+    size_t size = cachedFrame.topic.size() + cachedFrame.frame.size();
+
+    if (size > lastValueCacheCapacity_) return;
+
+    std::string_view key = cachedFrame.topic;
+    lastValueCache.emplace(key, std::move(cachedFrame));
+    shard->lastValueCacheSize += size;
+
+    while (shard->lastValueCacheSize > lastValueCacheCapacity_) {
+        const QueuedFrame &oldestFrame = lastValueCache.front().second;
+        shard->lastValueCacheSize -= oldestFrame.topic.size() + oldestFrame.frame.size();
+        lastValueCache.erase(lastValueCache.begin());
+    }
+}
+
+// Sends the last-value snapshot to a socket whose snapshot is pending, filtered through its subscription if
+// it has sent one, followed by the frames held back while it was pending.
+void Publisher::sendSnapshot(Shard *shard, FramingSocket *socket) {
+    auto i = shard->snapshotPending.find(socket);
+
+    if (i == shard->snapshotPending.end()) return;
+
+    std::vector<QueuedFrame> heldFrames = std::move(i->second);
+    shard->snapshotPending.erase(i);
+
+    std::optional<TopicMatcher<bool>> topicMatcher;
+
+    if (auto j = shard->socketToTopics.find(socket); j != shard->socketToTopics.end()) {
+        topicMatcher.emplace();
+
+        for (const std::string &topic : j->second) {
+            topicMatcher->add(topic, true);
+        }
+    }
+
+    auto matches = [this, &topicMatcher](const SharedBuffer &frame) {
+        return !topicMatcher || topicMatcher->matches(frameMessage(frame));
+    };
+
+    LOG(debug, "frames: size={}, heldFrames: size={}", shard->lastValueCache.size(), heldFrames.size());
+
+    if (slowSubscriberPolicy_ == SlowSubscriberPolicy::kNone) {
+        std::vector<SharedBuffer> frames;
+        frames.reserve(shard->lastValueCache.size());
+
+        for (const auto &[topic, cachedFrame] : shard->lastValueCache) {
+            if (matches(cachedFrame.frame)) {
+                frames.emplace_back(cachedFrame.frame);
+            }
+        }
+
+        // open() checks that the cache fits in the send buffer.
+        if (int error = socket->sendFrames(frames)) {
+            LOG(warning, "send: error={}", strerrorname_np(error));
+        }
+    } else {
+        Backlog &backlog = shard->backlogs.find(socket)->second;
+
+        for (const auto &[topic, cachedFrame] : shard->lastValueCache) {
+            if (matches(cachedFrame.frame)) {
+                enqueueFrame(shard, socket, backlog, cachedFrame.frame, cachedFrame.topic);
+            }
+        }
+
+        onFramingSocketSendComplete(shard, socket);
+    }
+
+    // A held frame whose topic is still cached is superseded by the snapshot.
+    for (const QueuedFrame &heldFrame : heldFrames) {
+        if (!heldFrame.topic.empty() && shard->lastValueCache.find(heldFrame.topic) != shard->lastValueCache.end()) {
+            continue;
+        }
+
+        if (matches(heldFrame.frame)) {
+            sendSocket(shard, socket, heldFrame.frame, heldFrame.topic);
+        }
+    }
+}
+
+std::string_view Publisher::frameMessage(const SharedBuffer &frame) const {
+    std::string_view message = std::string_view(frame).substr(4);
+
+    if (sequenced_) {
+        uint64_t sequence;
+        std::string_view topic;
+        decodeSequenceHeader(message, sequence, topic);
+    }
+
+    return message;
+}
+
+void Publisher::closeShard(Shard *shard) {
+    LOG(debug, "");
+
+    for (const std::shared_ptr<FramingSocket> &socket : shard->sockets) {
+        socket->reset();
+    }
+
+    shard->loop->post([sockets = std::move(shard->sockets)] {});
+
+    shard->sockets.clear();
+    shard->unfilteredSockets.clear();
+    shard->backlogs.clear();
+    shard->snapshotPending.clear();
+    shard->lastValueCache.clear();
+    shard->lastValueCacheSize = 0;
+    shard->socketToTopics.clear();
+    shard->topicMatcher.clear();
+
+    shard->token = nullptr;
+}
+
+void Publisher::adjustBlockedSockets(int delta) {
+    if (loop_->isInLoopThread()) {
+        numBlockedSockets_ += delta;
+
+        if (numBlockedSockets_ == 0) {
+            releaseWritableWaiters();
+        }
+    } else {
+        loop_->post([this, delta, token = std::weak_ptr(token_)] {
+            if (token.expired()) return;
+
+            adjustBlockedSockets(delta);
+        });
+    }
+}
+
+void Publisher::releaseWritableWaiters() {
+    if (!writablePromise_) return;
+
+    writablePromise_->set_value();
+    writablePromise_.reset();
+}
+
+void Publisher::addSubscription(Shard *shard, FramingSocket *socket, std::vector<std::string> topics) {
+    for (const std::string &topic : topics) {
+        shard->topicMatcher.add(topic, socket);
+    }
+
+    shard->socketToTopics.emplace(socket, std::move(topics));
+}
+
+void Publisher::removeSubscription(Shard *shard, FramingSocket *socket) {
+    auto i = shard->socketToTopics.find(socket);
+
+    if (i == shard->socketToTopics.end()) {
+        shard->unfilteredSockets.erase(socket);
+        return;
+    }
+
+    for (const std::string &topic : i->second) {
+        shard->topicMatcher.remove(topic, socket);
+    }
+
+    shard->socketToTopics.erase(i);
+}
+
+bool Publisher::onFramingAcceptorAccept(Shard *shard, std::unique_ptr<FramingSocket> socket) {
     LOG(debug, "");
 
-    if (maxConnections_ > 0 && sockets_.size() == maxConnections_) {
+    if (shard->maxConnections > 0 && shard->sockets.size() == shard->maxConnections) {
         LOG(warning, "Too many connections");
 
         socket->reset();
 
-        loop_->post([socket = std::move(socket)] {});
+        shard->loop->post([socket = std::move(socket)] {});
 
         return true;
     }
 
-    socket->addCloseCallback([this, socket = socket.get()](int) {
-        return onFramingSocketClose(socket);
+    socket->addRecvCallback([this, shard, socket = socket.get()](std::string_view message) {
+        return onFramingSocketRecv(shard, socket, message);
     });
+    if (slowSubscriberPolicy_ != SlowSubscriberPolicy::kNone) {
+        socket->addSendCompleteCallback([this, shard, socket = socket.get()] {
+            return onFramingSocketSendComplete(shard, socket);
+        });
+    }
 
-    sockets_.insert(std::shared_ptr(std::move(socket)));
+    socket->addHighWatermarkCallback([this] {
+        return onFramingSocketHighWatermark();
+    });
+    socket->addDrainedCallback([this] {
+        return onFramingSocketDrained();
+    });
+    socket->addCloseCallback([this, shard, socket = socket.get()](int) {
+        return onFramingSocketClose(shard, socket);
+    });
+
+    FramingSocket *acceptedSocket = socket.get();
+
+    shard->unfilteredSockets.insert(acceptedSocket);
+    shard->backlogs.try_emplace(acceptedSocket);
+    shard->sockets.insert(std::shared_ptr(std::move(socket)));
+
+    // The snapshot waits for the subscription so that it can be filtered, and live frames are held back
+    // until then so that it still comes first. A subscriber that never sends one gets it unfiltered.
+    if (!shard->lastValueCache.empty()) {
+        shard->snapshotPending.try_emplace(acceptedSocket);
+
+        shard->loop->postTimed([this,
+                                shard,
+                                socket = std::weak_ptr(acceptedSocket->shared_from_this()),
+                                token = std::weak_ptr(shard->token)] {
+            if (token.expired()) return;
+
+            if (std::shared_ptr<FramingSocket> lockedSocket = socket.lock()) {
+                sendSnapshot(shard, lockedSocket.get());
+            }
+        }, kSnapshotGracePeriod);
+    }
+
+    return true;
+}
+
+bool Publisher::onFramingSocketRecv(Shard *shard, FramingSocket *socket, std::string_view message) {
+    LOG(debug, "");
+
+    std::vector<std::string> topics;
+
+    if (!decodeSubscription(message, topics)) {
+        LOG(warning, "Bad subscription");
+
+        return true;
+    }
+
+    removeSubscription(shard, socket);
+    addSubscription(shard, socket, std::move(topics));
+
+    sendSnapshot(shard, socket);
 
     return true;
 }
 
-bool Publisher::onFramingSocketClose(FramingSocket *socket) {
+bool Publisher::onFramingSocketSendComplete(Shard *shard, FramingSocket *socket) {
+    LOG(debug, "");
+
+    Backlog &backlog = shard->backlogs.find(socket)->second;
+
+    if (backlog.draining) return true;
+
+    backlog.draining = true;
+
+    while (!backlog.frames.empty()) {
+        SharedBuffer frame = backlog.frames.front().frame;
+        popFrame(backlog);
+
+        if (int error = socket->sendFrame(std::move(frame))) {
+            LOG(warning, "send: error={}", strerrorname_np(error));
+        }
+
+        if (socket->state() != FramingSocket::State::kConnected) return true;
+
+        if (socket->socket().sendBufferSize() > 0) break;
+    }
+
+    backlog.draining = false;
+
+    return true;
+}
+
+bool Publisher::onFramingSocketHighWatermark() {
+    LOG(debug, "");
+
+    adjustBlockedSockets(1);
+
+    return true;
+}
+
+bool Publisher::onFramingSocketDrained() {
+    LOG(debug, "");
+
+    adjustBlockedSockets(-1);
+
+    return true;
+}
+
+bool Publisher::onFramingSocketClose(Shard *shard, FramingSocket *socket) {
     LOG(debug, "");
 
     socket->reset();
 
-    loop_->post([socket = socket->shared_from_this()] {});
+    shard->loop->post([socket = socket->shared_from_this()] {});
+
+    removeSubscription(shard, socket);
 
-    sockets_.erase(sockets_.find(socket));
+    shard->backlogs.erase(socket);
+    shard->snapshotPending.erase(socket);
+    shard->sockets.erase(shard->sockets.find(socket));
 
     return true;
 }
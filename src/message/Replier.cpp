@@ -11,6 +11,8 @@
 #include <utility>
 #include <vector>
 
+#include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingAcceptor.h"
 #include "mq/net/FramingSocket.h"
@@ -26,69 +28,63 @@
 using namespace mq;
 
 void Replier::Promise::operator()(MaybeOwnedString replyMessage) {
-    if (token_.expired() || replier_->sockets_.find(socket_.get()) == replier_->sockets_.end()) {
-        replier_->loop_->post([socket = std::move(socket_)] {});
+    if (token_.expired() || shard_->sockets.find(socket_.get()) == shard_->sockets.end()) {
+        shard_->loop->post([socket = std::move(socket_)] {});
 
         return;
     }
 
-    if (replier_->loop_->isInLoopThread()) {
-        if (int error = socket_->send(replyMessage)) {
+    if (shard_->loop->isInLoopThread()) {
+        if (int error = socket_->send(std::move(replyMessage))) {
             LOG(warning, "send: error={}", strerrorname_np(error));
 
-            replier_->loop_->post([replier = replier_,
-                                   socket = std::move(socket_),
-                                   token = std::weak_ptr(token_)] mutable {
-                if (token.expired() || replier->sockets_.find(socket.get()) == replier->sockets_.end()) return;
+            shard_->loop->post([shard = shard_,
+                                socket = std::move(socket_),
+                                token = std::weak_ptr(token_)] mutable {
+                if (token.expired() || shard->sockets.find(socket.get()) == shard->sockets.end()) return;
 
                 socket->reset();
 
-                replier->sockets_.erase(replier->sockets_.find(socket.get()));
+                shard->sockets.erase(shard->sockets.find(socket.get()));
             });
         }
     } else {
-        replier_->loop_->post([replier = replier_,
-                               socket = std::move(socket_),
-                               token = std::weak_ptr(token_),
-                               replyMessage = std::string(std::move(replyMessage))] {
-            if (token.expired() || replier->sockets_.find(socket.get()) == replier->sockets_.end()) return;
+        shard_->loop->post([shard = shard_,
+                            socket = std::move(socket_),
+                            token = std::weak_ptr(token_),
+                            replyMessage = std::string(std::move(replyMessage))] mutable {
+            if (token.expired() || shard->sockets.find(socket.get()) == shard->sockets.end()) return;
 
-            if (int error = socket->send(replyMessage)) {
+            if (int error = socket->send(std::move(replyMessage))) {
                 LOG(warning, "send: error={}", strerrorname_np(error));
 
                 socket->reset();
 
-                replier->sockets_.erase(replier->sockets_.find(socket));
+                shard->sockets.erase(shard->sockets.find(socket));
             }
         });
     }
 }
 
 void Replier::Promise::operator()(std::vector<MaybeOwnedString> replyPieces) {
-    if (token_.expired() || replier_->sockets_.find(socket_.get()) == replier_->sockets_.end()) {
-        replier_->loop_->post([socket = std::move(socket_)] {});
+    if (token_.expired() || shard_->sockets.find(socket_.get()) == shard_->sockets.end()) {
+        shard_->loop->post([socket = std::move(socket_)] {});
 
         return;
     }
 
-    if (replier_->loop_->isInLoopThread()) {
-        std::vector<std::string_view> pieces;
-        pieces.reserve(replyPieces.size());
-        for (const MaybeOwnedString &replyPiece : replyPieces) {
-            pieces.push_back(std::string_view(replyPiece));
-        }
-
-        if (int error = socket_->send(pieces)) {
+    if (shard_->loop->isInLoopThread()) {
+        if (int error = socket_->send(replyPieces)) {
             LOG(warning, "send: error={}", strerrorname_np(error));
 
-            replier_->loop_->post([replier = replier_,
-                                   socket = std::move(socket_),
-                                   token = std::weak_ptr(token_)] mutable {
-                if (token.expired() || replier->sockets_.find(socket.get()) == replier->sockets_.end()) return;
+            shard_->loop->post([shard = shard_,
+                                socket = std::move(socket_),
+                                token = std::weak_ptr(token_)] mutable {
+                if (token.expired() || shard->sockets.find(socket.get()) == shard->sockets.end()) return;
 
                 socket->reset();
 
-                replier->sockets_.erase(replier->sockets_.find(socket.get()));
+                shard->sockets.erase(shard->sockets.find(socket.get()));
             });
         }
     } else {
@@ -109,18 +105,18 @@ void Replier::Promise::operator()(std::vector<MaybeOwnedString> replyPieces) {
         std::string replyMessage;
         replyMessage.resize_and_overwrite(size, std::move(op));
 
-        replier_->loop_->post([replier = replier_,
-                               socket = std::move(socket_),
-                               token = std::weak_ptr(token_),
-                               replyMessage = std::move(replyMessage)] {
-            if (token.expired() || replier->sockets_.find(socket.get()) == replier->sockets_.end()) return;
+        shard_->loop->post([shard = shard_,
+                            socket = std::move(socket_),
+                            token = std::weak_ptr(token_),
+                            replyMessage = std::move(replyMessage)] mutable {
+            if (token.expired() || shard->sockets.find(socket.get()) == shard->sockets.end()) return;
 
-            if (int error = socket->send(replyMessage)) {
+            if (int error = socket->send(std::move(replyMessage))) {
                 LOG(warning, "send: error={}", strerrorname_np(error));
 
                 socket->reset();
 
-                replier->sockets_.erase(replier->sockets_.find(socket));
+                shard->sockets.erase(shard->sockets.find(socket));
             }
         });
     }
@@ -292,6 +288,118 @@ void Replier::setKeepAlive(KeepAlive keepAlive) {
     }
 }
 
+void Replier::setZeroCopyThreshold(size_t zeroCopyThreshold) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        zeroCopyThreshold_ = zeroCopyThreshold;
+    } else {
+        loop_->postAndWait([this, zeroCopyThreshold] {
+            CHECK(state_ == State::kClosed);
+
+            zeroCopyThreshold_ = zeroCopyThreshold;
+        });
+    }
+}
+
+void Replier::setWriteCoalescing(bool writeCoalescing) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        writeCoalescing_ = writeCoalescing;
+    } else {
+        loop_->postAndWait([this, writeCoalescing] {
+            CHECK(state_ == State::kClosed);
+
+            writeCoalescing_ = writeCoalescing;
+        });
+    }
+}
+
+void Replier::setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        writeCoalescingDelay_ = writeCoalescingDelay;
+    } else {
+        loop_->postAndWait([this, writeCoalescingDelay] {
+            CHECK(state_ == State::kClosed);
+
+            writeCoalescingDelay_ = writeCoalescingDelay;
+        });
+    }
+}
+
+void Replier::setWorkerGroup(EventLoopGroup *workerGroup) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        workerGroup_ = workerGroup;
+    } else {
+        loop_->postAndWait([this, workerGroup] {
+            CHECK(state_ == State::kClosed);
+
+            workerGroup_ = workerGroup;
+        });
+    }
+}
+
+void Replier::setSharded(bool sharded) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        sharded_ = sharded;
+    } else {
+        loop_->postAndWait([this, sharded] {
+            CHECK(state_ == State::kClosed);
+
+            sharded_ = sharded;
+        });
+    }
+}
+
+void Replier::setCpuSteering(bool cpuSteering) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        cpuSteering_ = cpuSteering;
+    } else {
+        loop_->postAndWait([this, cpuSteering] {
+            CHECK(state_ == State::kClosed);
+
+            cpuSteering_ = cpuSteering;
+        });
+    }
+}
+
+void Replier::setMaxInFlightMessages(size_t maxInFlightMessages) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxInFlightMessages_ = maxInFlightMessages;
+    } else {
+        loop_->postAndWait([this, maxInFlightMessages] {
+            CHECK(state_ == State::kClosed);
+
+            maxInFlightMessages_ = maxInFlightMessages;
+        });
+    }
+}
+
+void Replier::setMaxInFlightBytes(size_t maxInFlightBytes) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxInFlightBytes_ = maxInFlightBytes;
+    } else {
+        loop_->postAndWait([this, maxInFlightBytes] {
+            CHECK(state_ == State::kClosed);
+
+            maxInFlightBytes_ = maxInFlightBytes;
+        });
+    }
+}
+
 void Replier::setRecvCallback(RecvCallback recvCallback) {
     if (loop_->isInLoopThread()) {
         recvCallback_ = std::move(recvCallback);
@@ -342,6 +450,21 @@ int Replier::open() {
     if (loop_->isInLoopThread()) {
         CHECK(state_ == State::kClosed);
 
+        if (!workerGroup_) {
+            shards_.emplace_back(std::make_shared<Shard>(loop_, maxConnections_));
+        } else {
+            size_t numWorkers = workerGroup_->size();
+            size_t maxConnections = (maxConnections_ + numWorkers - 1) / numWorkers;
+
+            for (EventLoop *worker : workerGroup_->loops()) {
+                shards_.emplace_back(std::make_shared<Shard>(worker, maxConnections));
+            }
+        }
+
+        for (const std::shared_ptr<Shard> &shard : shards_) {
+            shard->token = std::make_shared<Empty>();
+        }
+
         acceptor_ = std::make_unique<FramingAcceptor>(loop_);
 
         acceptor_->setMaxMessageLength(maxMessageLength_);
@@ -354,19 +477,48 @@ int Replier::open() {
         acceptor_->setReusePort(reusePort_);
         acceptor_->setNoDelay(noDelay_);
         acceptor_->setKeepAlive(keepAlive_);
+        acceptor_->setZeroCopyThreshold(zeroCopyThreshold_);
+        acceptor_->setWriteCoalescing(writeCoalescing_);
+        acceptor_->setWriteCoalescingDelay(writeCoalescingDelay_);
 
-        acceptor_->addAcceptCallback([this](std::unique_ptr<FramingSocket> socket, const Endpoint &) {
-            return onFramingAcceptorAccept(std::move(socket));
-        });
+        if (!workerGroup_) {
+            acceptor_->addAcceptCallback([this](std::unique_ptr<FramingSocket> socket, const Endpoint &) {
+                return onFramingAcceptorAccept(shards_.front().get(), std::move(socket));
+            });
+        } else {
+            acceptor_->setWorkerGroup(workerGroup_);
+            acceptor_->setSharded(sharded_);
+            acceptor_->setCpuSteering(cpuSteering_);
+            acceptor_->setWorkerAcceptCallback([this, shards = shards_](std::unique_ptr<FramingSocket> socket,
+                                                                        const Endpoint &) {
+                for (const std::shared_ptr<Shard> &shard : shards) {
+                    if (shard->loop == socket->loop()) {
+                        if (!shard->token) {
+                            socket->reset();
+
+                            shard->loop->post([socket = std::move(socket)] {});
+
+                            return;
+                        }
+
+                        onFramingAcceptorAccept(shard.get(), std::move(socket));
+
+                        return;
+                    }
+                }
+
+                std::unreachable();
+            });
+        }
 
         error = acceptor_->open(*localEndpoint_);
         if (error) {
             loop_->post([acceptor = std::move(acceptor_)] {});
 
             acceptor_ = nullptr;
-        } else {
-            token_ = std::make_shared<Empty>();
 
+            shards_.clear();
+        } else {
             State oldState = state_;
             state_ = State::kOpened;
             LOG(debug, "{} -> {}", oldState, state_);
@@ -392,7 +544,17 @@ void Replier::close() {
 
         acceptor_ = nullptr;
 
-        token_ = nullptr;
+        for (const std::shared_ptr<Shard> &shard : shards_) {
+            if (shard->loop->isInLoopThread()) {
+                closeShard(shard.get());
+            } else {
+                shard->loop->postAndWait([shard = shard.get()] {
+                    closeShard(shard);
+                });
+            }
+        }
+
+        shards_.clear();
 
         State oldState = state_;
         state_ = State::kClosed;
@@ -404,64 +566,133 @@ void Replier::close() {
     }
 }
 
-bool Replier::onFramingAcceptorAccept(std::unique_ptr<FramingSocket> socket) {
+void Replier::closeShard(Shard *shard) {
     LOG(debug, "");
 
-    if (maxConnections_ > 0 && sockets_.size() == maxConnections_) {
+    for (const std::shared_ptr<FramingSocket> &socket : shard->sockets) {
+        socket->reset();
+    }
+
+    shard->loop->post([sockets = std::move(shard->sockets)] {});
+
+    shard->sockets.clear();
+
+    shard->token = nullptr;
+}
+
+bool Replier::onFramingAcceptorAccept(Shard *shard, std::unique_ptr<FramingSocket> socket) {
+    LOG(debug, "");
+
+    if (shard->maxConnections > 0 && shard->sockets.size() == shard->maxConnections) {
         LOG(warning, "Too many connections");
 
         socket->reset();
 
-        loop_->post([socket = std::move(socket)] {});
+        shard->loop->post([socket = std::move(socket)] {});
 
         return true;
     }
 
-    socket->addRecvCallback([this, socket = socket.get()](std::string_view message) {
-        return onFramingSocketRecv(socket, message);
+    socket->addRecvCallback([this, shard, socket = socket.get()](std::string_view message) {
+        return onFramingSocketRecv(shard, socket, message);
     });
 
-    socket->addCloseCallback([this, socket = socket.get()](int) {
-        return onFramingSocketClose(socket);
+    socket->addCloseCallback([this, shard, socket = socket.get()](int) {
+        return onFramingSocketClose(shard, socket);
     });
 
-    sockets_.insert(std::shared_ptr(std::move(socket)));
+    if (shard->recvPaused) socket->pauseRecv();
+
+    shard->sockets.insert(std::shared_ptr(std::move(socket)));
 
     return true;
 }
 
-bool Replier::onFramingSocketRecv(FramingSocket *socket, std::string_view message) {
+bool Replier::onFramingSocketRecv(Shard *shard, FramingSocket *socket, std::string_view message) {
     LOG(debug, "");
 
     std::unique_ptr<Endpoint> remoteEndpoint = socket->remoteEndpoint();
 
-    Promise promise(this, socket->shared_from_this(), std::weak_ptr(token_));
+    Promise promise(shard->shared_from_this(), socket->shared_from_this(), std::weak_ptr(shard->token));
 
     if (!recvCallbackExecutor_) {
         dispatchRecv(*remoteEndpoint, message, std::move(promise));
     } else {
+        bool bounded = maxInFlightMessages_ > 0 || maxInFlightBytes_ > 0;
+
+        if (bounded) acquireInFlight(shard, socket, message.size());
+
         recvCallbackExecutor_->post([this,
+                                     shard = shard->shared_from_this(),
                                      remoteEndpoint = std::move(remoteEndpoint),
                                      message = std::string(message),
                                      promise = std::move(promise),
-                                     token = std::weak_ptr(token_)] mutable {
+                                     token = std::weak_ptr(shard->token),
+                                     bounded] mutable {
             if (token.expired()) return;
 
             dispatchRecv(*remoteEndpoint, message, std::move(promise));
+
+            if (bounded) {
+                shard->loop->post([this, shard, size = message.size(), token] {
+                    if (token.expired()) return;
+
+                    releaseInFlight(shard.get(), size);
+                });
+            }
         });
     }
 
     return true;
 }
 
-bool Replier::onFramingSocketClose(FramingSocket *socket) {
+bool Replier::onFramingSocketClose(Shard *shard, FramingSocket *socket) {
     LOG(debug, "");
 
     socket->reset();
 
-    loop_->post([socket = socket->shared_from_this()] {});
+    shard->loop->post([socket = socket->shared_from_this()] {});
 
-    sockets_.erase(sockets_.find(socket));
+    shard->sockets.erase(shard->sockets.find(socket));
 
     return true;
 }
+
+void Replier::acquireInFlight(Shard *shard, FramingSocket *socket, size_t size) {
+    ++shard->inFlightMessages;
+    shard->inFlightBytes += size;
+
+    if (shard->recvPaused) {
+        socket->pauseRecv();
+        return;
+    }
+
+    if ((maxInFlightMessages_ > 0 && shard->inFlightMessages >= maxInFlightMessages_) ||
+        (maxInFlightBytes_ > 0 && shard->inFlightBytes >= maxInFlightBytes_)) {
+        LOG(debug, "Pausing recv: inFlightMessages={}, inFlightBytes={}", shard->inFlightMessages, shard->inFlightBytes);
+
+        shard->recvPaused = true;
+
+        for (const std::shared_ptr<FramingSocket> &socket : shard->sockets) {
+            socket->pauseRecv();
+        }
+    }
+}
+
+void Replier::releaseInFlight(Shard *shard, size_t size) {
+    --shard->inFlightMessages;
+    shard->inFlightBytes -= size;
+
+    if (!shard->recvPaused) return;
+
+    if ((maxInFlightMessages_ == 0 || shard->inFlightMessages <= maxInFlightMessages_ / 2) &&
+        (maxInFlightBytes_ == 0 || shard->inFlightBytes <= maxInFlightBytes_ / 2)) {
+        LOG(debug, "Resuming recv: inFlightMessages={}, inFlightBytes={}", shard->inFlightMessages, shard->inFlightBytes);
+
+        shard->recvPaused = false;
+
+        for (const std::shared_ptr<FramingSocket> &socket : shard->sockets) {
+            socket->resumeRecv();
+        }
+    }
+}
@@ -9,6 +9,7 @@
 #include <future>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -163,6 +164,62 @@ void Requester::setKeepAlive(KeepAlive keepAlive) {
     }
 }
 
+void Requester::setHighWatermark(size_t highWatermark) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        highWatermark_ = highWatermark;
+    } else {
+        loop_->postAndWait([this, highWatermark] {
+            CHECK(state_ == State::kClosed);
+
+            highWatermark_ = highWatermark;
+        });
+    }
+}
+
+void Requester::setLowWatermark(size_t lowWatermark) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        lowWatermark_ = lowWatermark;
+    } else {
+        loop_->postAndWait([this, lowWatermark] {
+            CHECK(state_ == State::kClosed);
+
+            lowWatermark_ = lowWatermark;
+        });
+    }
+}
+
+void Requester::setMaxInFlightMessages(size_t maxInFlightMessages) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxInFlightMessages_ = maxInFlightMessages;
+    } else {
+        loop_->postAndWait([this, maxInFlightMessages] {
+            CHECK(state_ == State::kClosed);
+
+            maxInFlightMessages_ = maxInFlightMessages;
+        });
+    }
+}
+
+void Requester::setMaxInFlightBytes(size_t maxInFlightBytes) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxInFlightBytes_ = maxInFlightBytes;
+    } else {
+        loop_->postAndWait([this, maxInFlightBytes] {
+            CHECK(state_ == State::kClosed);
+
+            maxInFlightBytes_ = maxInFlightBytes;
+        });
+    }
+}
+
 void Requester::setConnectCallback(ConnectCallback connectCallback) {
     if (loop_->isInLoopThread()) {
         CHECK(state_ == State::kClosed);
@@ -261,6 +318,10 @@ void Requester::open() {
 
         token_ = std::make_shared<Empty>();
 
+        inFlightMessages_ = 0;
+        inFlightBytes_ = 0;
+        recvPaused_ = false;
+
         socket_ = std::make_unique<FramingSocket>(loop_);
 
         socket_->setMaxMessageLength(maxMessageLength_);
@@ -271,6 +332,8 @@ void Requester::open() {
         socket_->setSendTimeout(sendTimeout_);
         socket_->setNoDelay(noDelay_);
         socket_->setKeepAlive(keepAlive_);
+        socket_->setHighWatermark(highWatermark_);
+        socket_->setLowWatermark(lowWatermark_);
 
         socket_->addConnectCallback([this](int error) {
             return onFramingSocketConnect(error);
@@ -342,13 +405,64 @@ int Requester::waitForConnected(std::chrono::nanoseconds timeout) {
     return 0;
 }
 
+bool Requester::writable() const {
+    bool writable;
+
+    if (loop_->isInLoopThread()) {
+        writable = state_ == State::kClosed || socket_->writable();
+    } else {
+        loop_->postAndWait([this, &writable] {
+            writable = state_ == State::kClosed || socket_->writable();
+        });
+    }
+
+    return writable;
+}
+
+int Requester::waitForWritable(std::chrono::nanoseconds timeout) {
+    CHECK(!loop_->isInLoopThread());
+
+    std::shared_future<void> future;
+
+    // Waiters share one promise and drained callback per blocked episode, so waits that time out leave
+    // nothing behind.
+    loop_->postAndWait([this, &future] {
+        if (state_ == State::kClosed || socket_->writable()) return;
+
+        if (!writablePromise_) {
+            writablePromise_.emplace();
+            writableFuture_ = writablePromise_->get_future().share();
+
+            socket_->addDrainedCallback([this] {
+                releaseWritableWaiters();
+
+                return false;
+            });
+        }
+
+        future = writableFuture_;
+    });
+
+    if (!future.valid()) return 0;
+
+    if (timeout.count() == 0) {
+        future.wait();
+    } else {
+        if (future.wait_for(timeout) != std::future_status::ready) {
+            return ETIMEDOUT;
+        }
+    }
+
+    return 0;
+}
+
 void Requester::send(MaybeOwnedString message) {
     LOG(debug, "");
 
     if (loop_->isInLoopThread()) {
         CHECK(state_ == State::kOpened);
 
-        if (int error = socket_->send(message)) {
+        if (int error = socket_->send(std::move(message))) {
             LOG(warning, "send: error={}", strerrorname_np(error));
         }
     } else {
@@ -366,10 +480,7 @@ void Requester::send(std::vector<MaybeOwnedString> pieces) {
     if (loop_->isInLoopThread()) {
         CHECK(state_ == State::kOpened);
 
-        std::vector<std::string_view> newPieces(std::make_move_iterator(pieces.begin()),
-                                                std::make_move_iterator(pieces.end()));
-
-        if (int error = socket_->send(newPieces)) {
+        if (int error = socket_->send(pieces)) {
             LOG(warning, "send: error={}", strerrorname_np(error));
         }
     } else {
@@ -412,6 +523,8 @@ void Requester::close() {
 
         token_ = nullptr;
 
+        releaseWritableWaiters();
+
         State oldState = state_;
         state_ = State::kClosed;
         LOG(debug, "{} -> {}", oldState, state_);
@@ -422,6 +535,13 @@ void Requester::close() {
     }
 }
 
+void Requester::releaseWritableWaiters() {
+    if (!writablePromise_) return;
+
+    writablePromise_->set_value();
+    writablePromise_.reset();
+}
+
 bool Requester::onFramingSocketConnect(int error) {
     LOG(debug, "error={}", error);
 
@@ -446,12 +566,55 @@ bool Requester::onFramingSocketRecv(std::string_view message) {
     if (!recvCallbackExecutor_) {
         dispatchRecv(message);
     } else {
-        recvCallbackExecutor_->post([this, message = std::string(message), token = std::weak_ptr(token_)] {
+        bool bounded = maxInFlightMessages_ > 0 || maxInFlightBytes_ > 0;
+
+        if (bounded) acquireInFlight(message.size());
+
+        recvCallbackExecutor_->post([this, message = std::string(message), token = std::weak_ptr(token_), bounded] {
             if (token.expired()) return;
 
             dispatchRecv(message);
+
+            if (bounded) {
+                loop_->post([this, size = message.size(), token] {
+                    if (token.expired()) return;
+
+                    releaseInFlight(size);
+                });
+            }
         });
     }
 
     return true;
 }
+
+void Requester::acquireInFlight(size_t size) {
+    ++inFlightMessages_;
+    inFlightBytes_ += size;
+
+    if (!recvPaused_ &&
+        ((maxInFlightMessages_ > 0 && inFlightMessages_ >= maxInFlightMessages_) ||
+         (maxInFlightBytes_ > 0 && inFlightBytes_ >= maxInFlightBytes_))) {
+        LOG(debug, "Pausing recv: inFlightMessages={}, inFlightBytes={}", inFlightMessages_, inFlightBytes_);
+
+        recvPaused_ = true;
+    }
+
+    if (recvPaused_) socket_->pauseRecv();
+}
+
+void Requester::releaseInFlight(size_t size) {
+    --inFlightMessages_;
+    inFlightBytes_ -= size;
+
+    if (!recvPaused_) return;
+
+    if ((maxInFlightMessages_ == 0 || inFlightMessages_ <= maxInFlightMessages_ / 2) &&
+        (maxInFlightBytes_ == 0 || inFlightBytes_ <= maxInFlightBytes_ / 2)) {
+        LOG(debug, "Resuming recv: inFlightMessages={}, inFlightBytes={}", inFlightMessages_, inFlightBytes_);
+
+        recvPaused_ = false;
+
+        socket_->resumeRecv();
+    }
+}
@@ -4,18 +4,22 @@
 
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "mq/message/Subscription.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingSocket.h"
 #include "mq/net/Socket.h"
 #include "mq/utils/Check.h"
 #include "mq/utils/Empty.h"
 #include "mq/utils/Logging.h"
+#include "mq/utils/SharedBuffer.h"
 
 #define TAG "Subscriber"
 
@@ -143,6 +147,62 @@ void Subscriber::setKeepAlive(KeepAlive keepAlive) {
     }
 }
 
+void Subscriber::setMaxInFlightMessages(size_t maxInFlightMessages) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxInFlightMessages_ = maxInFlightMessages;
+    } else {
+        loop_->postAndWait([this, maxInFlightMessages] {
+            CHECK(state_ == State::kClosed);
+
+            maxInFlightMessages_ = maxInFlightMessages;
+        });
+    }
+}
+
+void Subscriber::setMaxInFlightBytes(size_t maxInFlightBytes) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxInFlightBytes_ = maxInFlightBytes;
+    } else {
+        loop_->postAndWait([this, maxInFlightBytes] {
+            CHECK(state_ == State::kClosed);
+
+            maxInFlightBytes_ = maxInFlightBytes;
+        });
+    }
+}
+
+void Subscriber::setSequenced(bool sequenced) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        sequenced_ = sequenced;
+    } else {
+        loop_->postAndWait([this, sequenced] {
+            CHECK(state_ == State::kClosed);
+
+            sequenced_ = sequenced;
+        });
+    }
+}
+
+void Subscriber::setMaxSequencedTopics(size_t maxSequencedTopics) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        maxSequencedTopics_ = maxSequencedTopics;
+    } else {
+        loop_->postAndWait([this, maxSequencedTopics] {
+            CHECK(state_ == State::kClosed);
+
+            maxSequencedTopics_ = maxSequencedTopics;
+        });
+    }
+}
+
 void Subscriber::setRecvCallback(RecvCallback recvCallback) {
     if (loop_->isInLoopThread()) {
         CHECK(state_ == State::kClosed);
@@ -179,6 +239,32 @@ void Subscriber::dispatchRecv(const Endpoint &remoteEndpoint, std::string_view m
     }
 }
 
+void Subscriber::setGapCallback(GapCallback gapCallback) {
+    if (loop_->isInLoopThread()) {
+        CHECK(state_ == State::kClosed);
+
+        gapCallback_ = std::move(gapCallback);
+    } else {
+        loop_->postAndWait([this, &gapCallback] {
+            CHECK(state_ == State::kClosed);
+
+            gapCallback_ = std::move(gapCallback);
+        });
+    }
+}
+
+void Subscriber::dispatchGap(const Endpoint &remoteEndpoint,
+                             std::string_view topic,
+                             uint64_t expectedSequence,
+                             uint64_t sequence) {
+    LOG(debug, "remoteEndpoint={}, topic={}, expectedSequence={}, sequence={}",
+        remoteEndpoint, topic, expectedSequence, sequence);
+
+    if (gapCallback_) {
+        gapCallback_(remoteEndpoint, topic, expectedSequence, sequence);
+    }
+}
+
 Subscriber::State Subscriber::state() const {
     State state;
 
@@ -205,6 +291,10 @@ void Subscriber::subscribe(const Endpoint &remoteEndpoint, std::vector<std::stri
             LOG(debug, "{} -> {}", oldState, state_);
 
             token_ = std::make_shared<Empty>();
+
+            inFlightMessages_ = 0;
+            inFlightBytes_ = 0;
+            recvPaused_ = false;
         }
 
         std::unique_ptr<FramingSocket> socket = std::make_unique<FramingSocket>(loop_);
@@ -218,6 +308,10 @@ void Subscriber::subscribe(const Endpoint &remoteEndpoint, std::vector<std::stri
         socket->setNoDelay(noDelay_);
         socket->setKeepAlive(keepAlive_);
 
+        socket->addConnectCallback([this, socket = socket.get()](int error) {
+            return onFramingSocketConnect(socket, error);
+        });
+
         socket->addRecvCallback([this, socket = socket.get()](std::string_view message) {
             return onFramingSocketRecv(socket, message);
         });
@@ -269,8 +363,16 @@ void Subscriber::subscribe(const Endpoint &remoteEndpoint, std::vector<std::stri
 
         socket->open(remoteEndpoint);
 
+        SocketTopics socketTopics;
+
+        for (const std::string &topic : topics) {
+            socketTopics.topicMatcher.add(topic, true);
+        }
+
+        socketTopics.topics = std::move(topics);
+
         endpointToSocket_.emplace(remoteEndpoint.clone(), socket.get());
-        socketToTopics_.emplace(socket.get(), std::move(topics));
+        socketToTopics_.emplace(socket.get(), std::move(socketTopics));
         sockets_.insert(std::shared_ptr(std::move(socket)));
     } else {
         loop_->postAndWait([this, &remoteEndpoint, &topics] {
@@ -287,6 +389,7 @@ void Subscriber::unsubscribe(const Endpoint &remoteEndpoint) {
         auto j = socketToTopics_.find(i->second);
         auto k = sockets_.find(i->second);
 
+        socketToSequences_.erase(j->first);
         endpointToSocket_.erase(i);
         socketToTopics_.erase(j);
 
@@ -310,33 +413,182 @@ void Subscriber::unsubscribe(const Endpoint &remoteEndpoint) {
     }
 }
 
+void Subscriber::setTopics(const Endpoint &remoteEndpoint, std::vector<std::string> topics) {
+    LOG(debug, "remoteEndpoint={}", remoteEndpoint);
+
+    if (loop_->isInLoopThread()) {
+        auto i = endpointToSocket_.find(remoteEndpoint);
+
+        CHECK(i != endpointToSocket_.end());
+
+        FramingSocket *socket = i->second;
+
+        SocketTopics &socketTopics = socketToTopics_.find(socket)->second;
+
+        socketTopics.topicMatcher.clear();
+
+        for (const std::string &topic : topics) {
+            socketTopics.topicMatcher.add(topic, true);
+        }
+
+        socketTopics.topics = std::move(topics);
+
+        if (socket->state() == FramingSocket::State::kConnected) {
+            sendSubscription(socket);
+        }
+    } else {
+        loop_->postAndWait([this, &remoteEndpoint, &topics] {
+            setTopics(remoteEndpoint, std::move(topics));
+        });
+    }
+}
+
+void Subscriber::sendSubscription(FramingSocket *socket) {
+    LOG(debug, "");
+
+    if (int error = socket->send(encodeSubscription(socketToTopics_.find(socket)->second.topics))) {
+        LOG(warning, "send: error={}", strerrorname_np(error));
+    }
+}
+
+bool Subscriber::onFramingSocketConnect(FramingSocket *socket, int error) {
+    LOG(debug, "error={}", error);
+
+    if (!error) {
+        sendSubscription(socket);
+    }
+
+    return true;
+}
+
 bool Subscriber::onFramingSocketRecv(FramingSocket *socket, std::string_view message) {
     LOG(debug, "");
 
+    uint64_t sequence = 0;
+    std::string_view topic;
+
+    if (sequenced_ && !decodeSequenceHeader(message, sequence, topic)) {
+        LOG(warning, "Bad sequence header");
+
+        return true;
+    }
+
+    if (!socketToTopics_.find(socket)->second.topicMatcher.matches(message)) return true;
+
+    if (sequence != 0) {
+        checkSequence(socket, topic, sequence);
+    }
+
     if (!recvCallbackExecutor_) {
-        for (const std::string &topic : socketToTopics_.find(socket)->second) {
-            if (message.starts_with(topic)) {
-                dispatchRecv(*socket->remoteEndpoint(), message);
-                break;
-            }
-        }
+        dispatchRecv(*socket->remoteEndpoint(), message);
     } else {
-        for (const std::string &topic : socketToTopics_.find(socket)->second) {
-            if (message.starts_with(topic)) {
-                recvCallbackExecutor_->post([this,
-                                             socket,
-                                             remoteEndpoint = socket->remoteEndpoint(),
-                                             message = std::string(message),
-                                             token = std::weak_ptr(token_)] {
-                    if (token.expired() || sockets_.find(socket) == sockets_.end()) return;
-
-                    dispatchRecv(*remoteEndpoint, message);
+        bool bounded = maxInFlightMessages_ > 0 || maxInFlightBytes_ > 0;
+
+        if (bounded) acquireInFlight(socket, message.size());
+
+        recvCallbackExecutor_->post([this,
+                                     socket,
+                                     remoteEndpoint = socket->remoteEndpoint(),
+                                     message = std::string(message),
+                                     token = std::weak_ptr(token_),
+                                     bounded] {
+            if (token.expired()) return;
+
+            if (sockets_.find(socket) != sockets_.end()) {
+                dispatchRecv(*remoteEndpoint, message);
+            }
+
+            if (bounded) {
+                loop_->post([this, size = message.size(), token] {
+                    if (token.expired()) return;
+
+                    releaseInFlight(size);
                 });
+            }
+        });
+    }
+
+    return true;
+}
+
+void Subscriber::checkSequence(FramingSocket *socket, std::string_view topic, uint64_t sequence) {
+    TopicToSequenceMap &topicToSequence = socketToSequences_[socket];
+
+    auto i = topicToSequence.find(topic);
 
-                break;
+    if (i == topicToSequence.end()) {
+        // Topics are evicted least recently used first. An evicted topic is treated as a first sighting.
+        if (maxSequencedTopics_ > 0 && topicToSequence.size() >= maxSequencedTopics_) {
+            topicToSequence.erase(topicToSequence.begin());
+        }
+
+        SharedBuffer storedTopic(topic);
+        std::string_view key = storedTopic;
+        topicToSequence.emplace(key, TopicSequence{std::move(storedTopic), sequence});
+        return;
+    }
+
+    topicToSequence.moveToBack(i);
+
+    uint64_t expectedSequence = i->second.sequence + 1;
+    i->second.sequence = sequence;
+
+    if (sequence <= expectedSequence) return;
+
+    if (!recvCallbackExecutor_) {
+        dispatchGap(*socket->remoteEndpoint(), topic, expectedSequence, sequence);
+    } else {
+        recvCallbackExecutor_->post([this,
+                                     socket,
+                                     remoteEndpoint = socket->remoteEndpoint(),
+                                     topic = std::string(topic),
+                                     expectedSequence,
+                                     sequence,
+                                     token = std::weak_ptr(token_)] {
+            if (token.expired()) return;
+
+            if (sockets_.find(socket) != sockets_.end()) {
+                dispatchGap(*remoteEndpoint, topic, expectedSequence, sequence);
             }
+        });
+    }
+}
+
+void Subscriber::acquireInFlight(FramingSocket *socket, size_t size) {
+    ++inFlightMessages_;
+    inFlightBytes_ += size;
+
+    if (recvPaused_) {
+        socket->pauseRecv();
+        return;
+    }
+
+    if ((maxInFlightMessages_ > 0 && inFlightMessages_ >= maxInFlightMessages_) ||
+        (maxInFlightBytes_ > 0 && inFlightBytes_ >= maxInFlightBytes_)) {
+        LOG(debug, "Pausing recv: inFlightMessages={}, inFlightBytes={}", inFlightMessages_, inFlightBytes_);
+
+        recvPaused_ = true;
+
+        for (const std::shared_ptr<FramingSocket> &socket : sockets_) {
+            socket->pauseRecv();
         }
     }
+}
 
-    return true;
+void Subscriber::releaseInFlight(size_t size) {
+    --inFlightMessages_;
+    inFlightBytes_ -= size;
+
+    if (!recvPaused_) return;
+
+    if ((maxInFlightMessages_ == 0 || inFlightMessages_ <= maxInFlightMessages_ / 2) &&
+        (maxInFlightBytes_ == 0 || inFlightBytes_ <= maxInFlightBytes_ / 2)) {
+        LOG(debug, "Resuming recv: inFlightMessages={}, inFlightBytes={}", inFlightMessages_, inFlightBytes_);
+
+        recvPaused_ = false;
+
+        for (const std::shared_ptr<FramingSocket> &socket : sockets_) {
+            socket->resumeRecv();
+        }
+    }
 }
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/message/Subscription.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mq/utils/Endian.h"
+
+using namespace mq;
+
+std::string mq::encodeSubscription(std::span<const std::string> topics) {
+    size_t length = 0;
+    for (const std::string &topic : topics) {
+        length += 4 + topic.size();
+    }
+
+    std::string message;
+    message.reserve(length);
+
+    for (const std::string &topic : topics) {
+        uint32_t topicLengthLE = toLittleEndian(static_cast<uint32_t>(topic.size()));
+        message.append(reinterpret_cast<const char *>(&topicLengthLE), 4);
+        message.append(topic);
+    }
+
+    return message;
+}
+
+bool mq::decodeSubscription(std::string_view message, std::vector<std::string> &topics) {
+    topics.clear();
+
+    while (!message.empty()) {
+        if (message.size() < 4) return false;
+
+        uint32_t topicLengthLE;
+        memcpy(&topicLengthLE, message.data(), 4);
+
+        uint32_t topicLength = fromLittleEndian(topicLengthLE);
+
+        if (message.size() - 4 < topicLength) return false;
+
+        topics.emplace_back(message.substr(4, topicLength));
+
+        message.remove_prefix(4 + topicLength);
+    }
+
+    return true;
+}
+
+void mq::encodeSequenceHeader(char *header, uint64_t sequence, size_t topicLength) {
+    setSequence(header, sequence);
+
+    uint16_t topicLengthLE = toLittleEndian(static_cast<uint16_t>(topicLength));
+    memcpy(header + 8, &topicLengthLE, 2);
+}
+
+void mq::setSequence(char *header, uint64_t sequence) {
+    uint64_t sequenceLE = toLittleEndian(sequence);
+    memcpy(header, &sequenceLE, 8);
+}
+
+bool mq::decodeSequenceHeader(std::string_view &message, uint64_t &sequence, std::string_view &topic) {
+    if (message.size() < kSequenceHeaderSize) return false;
+
+    uint64_t sequenceLE;
+    memcpy(&sequenceLE, message.data(), 8);
+
+    uint16_t topicLengthLE;
+    memcpy(&topicLengthLE, message.data() + 8, 2);
+
+    uint16_t topicLength = fromLittleEndian(topicLengthLE);
+
+    if (message.size() - kSequenceHeaderSize < topicLength) return false;
+
+    sequence = fromLittleEndian(sequenceLE);
+    topic = message.substr(kSequenceHeaderSize, topicLength);
+
+    message.remove_prefix(kSequenceHeaderSize + topicLength);
+
+    return true;
+}
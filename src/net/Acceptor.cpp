@@ -2,19 +2,25 @@
 
 #include "mq/net/Acceptor.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/Socket.h"
 #include "mq/net/Tcp6Endpoint.h"
@@ -60,6 +66,13 @@ void Acceptor::setRecvChunkSize(size_t recvChunkSize) {
     recvChunkSize_ = recvChunkSize;
 }
 
+void Acceptor::setRecvBudget(size_t recvBudget) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    recvBudget_ = recvBudget;
+}
+
 void Acceptor::setRecvTimeout(std::chrono::nanoseconds recvTimeout) {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kClosed);
@@ -102,6 +115,84 @@ void Acceptor::setKeepAlive(KeepAlive keepAlive) {
     keepAlive_ = keepAlive;
 }
 
+void Acceptor::setBusyPoll(std::chrono::microseconds busyPoll) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    busyPoll_ = busyPoll;
+}
+
+void Acceptor::setEdgeTriggered(bool edgeTriggered) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    edgeTriggered_ = edgeTriggered;
+}
+
+void Acceptor::setZeroCopyThreshold(size_t zeroCopyThreshold) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    zeroCopyThreshold_ = zeroCopyThreshold;
+}
+
+void Acceptor::setWriteCoalescing(bool writeCoalescing) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    writeCoalescing_ = writeCoalescing;
+}
+
+void Acceptor::setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+    CHECK(writeCoalescingDelay.count() >= 0);
+
+    writeCoalescingDelay_ = writeCoalescingDelay;
+}
+
+void Acceptor::setHighWatermark(size_t highWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    highWatermark_ = highWatermark;
+}
+
+void Acceptor::setLowWatermark(size_t lowWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    lowWatermark_ = lowWatermark;
+}
+
+void Acceptor::setWorkerGroup(EventLoopGroup *workerGroup) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    workerGroup_ = workerGroup;
+}
+
+void Acceptor::setWorkerAcceptCallback(WorkerAcceptCallback workerAcceptCallback) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    workerAcceptCallback_ = std::make_shared<WorkerAcceptCallback>(std::move(workerAcceptCallback));
+}
+
+void Acceptor::setSharded(bool sharded) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    sharded_ = sharded;
+}
+
+void Acceptor::setCpuSteering(bool cpuSteering) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    cpuSteering_ = cpuSteering;
+}
+
 Acceptor::State Acceptor::state() const {
     CHECK(loop_->isInLoopThread());
 
@@ -111,6 +202,7 @@ Acceptor::State Acceptor::state() const {
 int Acceptor::fd() const {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kListening);
+    CHECK(listeners_.empty());
 
     return fd_;
 }
@@ -118,6 +210,7 @@ int Acceptor::fd() const {
 Watcher &Acceptor::watcher() {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kListening);
+    CHECK(listeners_.empty());
 
     return *watcher_;
 }
@@ -125,6 +218,7 @@ Watcher &Acceptor::watcher() {
 const Watcher &Acceptor::watcher() const {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kListening);
+    CHECK(listeners_.empty());
 
     return *watcher_;
 }
@@ -174,6 +268,25 @@ int Acceptor::open(const Endpoint &localEndpoint) {
 
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kClosed);
+    CHECK(!workerGroup_ || (workerAcceptCallback_ && *workerAcceptCallback_));
+
+    if (workerGroup_ && sharded_) {
+        CHECK(reusePort_);
+
+        if (int error = openListeners(localEndpoint)) {
+            return error;
+        }
+
+        localEndpoint_ = localEndpoint.clone();
+
+        State oldState = state_;
+        state_ = State::kListening;
+        LOG(debug, "{} -> {}", oldState, state_);
+
+        LOG(info, "Listening on {} with {} listeners", *localEndpoint_, listeners_.size());
+
+        return 0;
+    }
 
     CHECK((fd_ = socket(localEndpoint.domain(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) >= 0);
     LOG(debug, "fd={}", fd_);
@@ -196,6 +309,7 @@ int Acceptor::open(const Endpoint &localEndpoint) {
     }
 
     watcher_ = std::make_unique<Watcher>(loop_, fd_);
+    watcher_->setTag(TAG);
     watcher_->registerSelf();
     watcher_->addReadReadyCallback([this] { return onWatcherReadReady(); });
 
@@ -221,16 +335,20 @@ void Acceptor::close() {
     state_ = State::kClosed;
     LOG(debug, "{} -> {}", oldState, state_);
 
-    watcher_->clearReadReadyCallbacks();
-    watcher_->clearWriteReadyCallbacks();
+    if (!listeners_.empty()) {
+        closeListeners();
+    } else {
+        watcher_->clearReadReadyCallbacks();
+        watcher_->clearWriteReadyCallbacks();
 
-    loop_->post([watcher = std::move(watcher_), fd = fd_] {
-        watcher->unregisterSelf();
+        loop_->post([watcher = std::move(watcher_), fd = fd_] {
+            watcher->unregisterSelf();
 
-        CHECK(::close(fd) == 0);
-    });
+            CHECK(::close(fd) == 0);
+        });
 
-    watcher_ = nullptr;
+        watcher_ = nullptr;
+    }
 
     localEndpoint_ = nullptr;
 }
@@ -248,20 +366,167 @@ void Acceptor::reset() {
     state_ = State::kClosed;
     LOG(debug, "{} -> {}", oldState, state_);
 
-    watcher_->clearReadReadyCallbacks();
-    watcher_->clearWriteReadyCallbacks();
+    if (!listeners_.empty()) {
+        closeListeners();
+    } else {
+        watcher_->clearReadReadyCallbacks();
+        watcher_->clearWriteReadyCallbacks();
 
-    loop_->post([watcher = std::move(watcher_), fd = fd_] {
-        watcher->unregisterSelf();
+        loop_->post([watcher = std::move(watcher_), fd = fd_] {
+            watcher->unregisterSelf();
 
-        CHECK(::close(fd) == 0);
-    });
+            CHECK(::close(fd) == 0);
+        });
 
-    watcher_ = nullptr;
+        watcher_ = nullptr;
+    }
 
     localEndpoint_ = nullptr;
 }
 
+namespace {
+
+// Builds a reuseport program that picks the listener whose worker is pinned to the CPU handling the
+// connection. Listener i belongs to worker i, so the program is a jump table from each pinned CPU to
+// its worker index. CPUs without a worker, and all CPUs when the group is not pinned, fall back to
+// cpu % numListeners. If several workers share a CPU, the first one receives its connections.
+std::vector<sock_filter> makeSteeringProgram(const EventLoopGroup &workerGroup) {
+    // Jump offsets are 8 bits wide, which bounds the size of the table.
+    constexpr size_t kMaxEntries = 254;
+
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+
+    for (size_t i = 0; i < workerGroup.size() && entries.size() < kMaxEntries; ++i) {
+        int cpu = workerGroup.cpu(i);
+
+        if (cpu < 0) continue;
+
+        bool duplicate = std::ranges::any_of(entries, [cpu](const auto &entry) {
+            return entry.first == static_cast<uint32_t>(cpu);
+        });
+
+        if (!duplicate) {
+            entries.emplace_back(static_cast<uint32_t>(cpu), static_cast<uint32_t>(i));
+        }
+    }
+
+    auto numEntries = static_cast<uint8_t>(entries.size());
+
+    std::vector<sock_filter> code;
+    code.reserve(3 + 2 * entries.size());
+
+    code.push_back({BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)});
+
+    // Each comparison jumps over the remaining comparisons, the fallback and the preceding returns.
+    for (const auto &[cpu, index] : entries) {
+        code.push_back({BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint8_t>(numEntries + 1), 0, cpu});
+    }
+
+    code.push_back({BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(workerGroup.size())});
+    code.push_back({BPF_RET | BPF_A, 0, 0, 0});
+
+    for (const auto &[cpu, index] : entries) {
+        code.push_back({BPF_RET | BPF_K, 0, 0, index});
+    }
+
+    return code;
+}
+
+} // namespace
+
+int Acceptor::openListeners(const Endpoint &localEndpoint) {
+    LOG(debug, "");
+
+    for (EventLoop *worker : workerGroup_->loops()) {
+        std::unique_ptr<Acceptor> listener = std::make_unique<Acceptor>(worker);
+        bool first = listeners_.empty();
+        int error;
+
+        auto openListener = [&] {
+            listener->setRecvBufferMaxCapacity(recvBufferMaxCapacity_);
+            listener->setSendBufferMaxCapacity(sendBufferMaxCapacity_);
+            listener->setRecvChunkSize(recvChunkSize_);
+            listener->setRecvBudget(recvBudget_);
+            listener->setRecvTimeout(recvTimeout_);
+            listener->setSendTimeout(sendTimeout_);
+            listener->setReuseAddr(reuseAddr_);
+            listener->setReusePort(reusePort_);
+            listener->setNoDelay(noDelay_);
+            listener->setKeepAlive(keepAlive_);
+            listener->setBusyPoll(busyPoll_);
+            listener->setEdgeTriggered(edgeTriggered_);
+            listener->setZeroCopyThreshold(zeroCopyThreshold_);
+            listener->setWriteCoalescing(writeCoalescing_);
+            listener->setWriteCoalescingDelay(writeCoalescingDelay_);
+            listener->setHighWatermark(highWatermark_);
+            listener->setLowWatermark(lowWatermark_);
+
+            listener->addAcceptCallback([workerAcceptCallback = workerAcceptCallback_](std::unique_ptr<Socket> socket,
+                                                                                       const Endpoint &remoteEndpoint) {
+                (*workerAcceptCallback)(std::move(socket), remoteEndpoint);
+                return true;
+            });
+
+            error = listener->open(localEndpoint);
+
+            if (!error && first && cpuSteering_) {
+                std::vector<sock_filter> code = makeSteeringProgram(*workerGroup_);
+
+                sock_fprog prog{};
+                prog.len = static_cast<unsigned short>(code.size());
+                prog.filter = code.data();
+
+                if (setsockopt(listener->fd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+                    error = errno;
+                    LOG(warning, "setsockopt: SO_ATTACH_REUSEPORT_CBPF: errno={}", strerrorname_np(error));
+                }
+            }
+
+            if (error && listener->state() == State::kListening) {
+                listener->reset();
+            }
+        };
+
+        if (worker->isInLoopThread()) {
+            openListener();
+        } else {
+            worker->postAndWait([&openListener] {
+                openListener();
+            });
+        }
+
+        if (error) {
+            worker->post([listener = std::move(listener)] {});
+
+            closeListeners();
+
+            return error;
+        }
+
+        listeners_.emplace_back(std::move(listener));
+    }
+
+    return 0;
+}
+
+void Acceptor::closeListeners() {
+    LOG(debug, "");
+
+    for (std::unique_ptr<Acceptor> &listener : listeners_) {
+        EventLoop *worker = listener->loop();
+
+        worker->post([listener = std::move(listener)] mutable {
+            listener->reset();
+
+            EventLoop *worker = listener->loop();
+
+            worker->post([listener = std::move(listener)] {});
+        });
+    }
+
+    listeners_.clear();
+}
+
 bool Acceptor::onWatcherReadReady() {
     LOG(debug, "");
 
@@ -310,15 +575,71 @@ bool Acceptor::onWatcherReadReady() {
 
     LOG(info, "Accepted connection from {}", *remoteEndpoint);
 
+    if (workerGroup_) {
+        EventLoop *worker = workerGroup_->next();
+
+        worker->post([worker,
+                      connFd,
+                      remoteEndpoint = std::move(remoteEndpoint),
+                      workerAcceptCallback = workerAcceptCallback_,
+                      recvBufferMaxCapacity = recvBufferMaxCapacity_,
+                      sendBufferMaxCapacity = sendBufferMaxCapacity_,
+                      recvChunkSize = recvChunkSize_,
+                      recvBudget = recvBudget_,
+                      recvTimeout = recvTimeout_,
+                      sendTimeout = sendTimeout_,
+                      noDelay = noDelay_,
+                      keepAlive = keepAlive_,
+                      busyPoll = busyPoll_,
+                      edgeTriggered = edgeTriggered_,
+                      zeroCopyThreshold = zeroCopyThreshold_,
+                      writeCoalescing = writeCoalescing_,
+                      writeCoalescingDelay = writeCoalescingDelay_,
+                      highWatermark = highWatermark_,
+                      lowWatermark = lowWatermark_] {
+            std::unique_ptr<Socket> socket = std::make_unique<Socket>(worker);
+
+            socket->setRecvBufferMaxCapacity(recvBufferMaxCapacity);
+            socket->setSendBufferMaxCapacity(sendBufferMaxCapacity);
+            socket->setRecvChunkSize(recvChunkSize);
+            socket->setRecvBudget(recvBudget);
+            socket->setRecvTimeout(recvTimeout);
+            socket->setSendTimeout(sendTimeout);
+            socket->setNoDelay(noDelay);
+            socket->setKeepAlive(keepAlive);
+            socket->setBusyPoll(busyPoll);
+            socket->setEdgeTriggered(edgeTriggered);
+            socket->setZeroCopyThreshold(zeroCopyThreshold);
+            socket->setWriteCoalescing(writeCoalescing);
+            socket->setWriteCoalescingDelay(writeCoalescingDelay);
+            socket->setHighWatermark(highWatermark);
+            socket->setLowWatermark(lowWatermark);
+
+            socket->open(connFd, *remoteEndpoint);
+
+            (*workerAcceptCallback)(std::move(socket), *remoteEndpoint);
+        });
+
+        return true;
+    }
+
     std::unique_ptr<Socket> socket = std::make_unique<Socket>(loop_);
 
     socket->setRecvBufferMaxCapacity(recvBufferMaxCapacity_);
     socket->setSendBufferMaxCapacity(sendBufferMaxCapacity_);
     socket->setRecvChunkSize(recvChunkSize_);
+    socket->setRecvBudget(recvBudget_);
     socket->setRecvTimeout(recvTimeout_);
     socket->setSendTimeout(sendTimeout_);
     socket->setNoDelay(noDelay_);
     socket->setKeepAlive(keepAlive_);
+    socket->setBusyPoll(busyPoll_);
+    socket->setEdgeTriggered(edgeTriggered_);
+    socket->setZeroCopyThreshold(zeroCopyThreshold_);
+    socket->setWriteCoalescing(writeCoalescing_);
+    socket->setWriteCoalescingDelay(writeCoalescingDelay_);
+    socket->setHighWatermark(highWatermark_);
+    socket->setLowWatermark(lowWatermark_);
 
     socket->open(connFd, *remoteEndpoint);
 
@@ -8,6 +8,7 @@
 #include <utility>
 
 #include "mq/event/EventLoop.h"
+#include "mq/event/EventLoopGroup.h"
 #include "mq/net/Acceptor.h"
 #include "mq/net/Endpoint.h"
 #include "mq/net/FramingSocket.h"
@@ -59,6 +60,13 @@ void FramingAcceptor::setRecvChunkSize(size_t recvChunkSize) {
     recvChunkSize_ = recvChunkSize;
 }
 
+void FramingAcceptor::setRecvBudget(size_t recvBudget) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    recvBudget_ = recvBudget;
+}
+
 void FramingAcceptor::setRecvTimeout(std::chrono::nanoseconds recvTimeout) {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kClosed);
@@ -101,6 +109,84 @@ void FramingAcceptor::setKeepAlive(KeepAlive keepAlive) {
     keepAlive_ = keepAlive;
 }
 
+void FramingAcceptor::setBusyPoll(std::chrono::microseconds busyPoll) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    busyPoll_ = busyPoll;
+}
+
+void FramingAcceptor::setEdgeTriggered(bool edgeTriggered) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    edgeTriggered_ = edgeTriggered;
+}
+
+void FramingAcceptor::setZeroCopyThreshold(size_t zeroCopyThreshold) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    zeroCopyThreshold_ = zeroCopyThreshold;
+}
+
+void FramingAcceptor::setWriteCoalescing(bool writeCoalescing) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    writeCoalescing_ = writeCoalescing;
+}
+
+void FramingAcceptor::setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+    CHECK(writeCoalescingDelay.count() >= 0);
+
+    writeCoalescingDelay_ = writeCoalescingDelay;
+}
+
+void FramingAcceptor::setHighWatermark(size_t highWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    highWatermark_ = highWatermark;
+}
+
+void FramingAcceptor::setLowWatermark(size_t lowWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    lowWatermark_ = lowWatermark;
+}
+
+void FramingAcceptor::setWorkerGroup(EventLoopGroup *workerGroup) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    workerGroup_ = workerGroup;
+}
+
+void FramingAcceptor::setWorkerAcceptCallback(WorkerAcceptCallback workerAcceptCallback) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    workerAcceptCallback_ = std::make_shared<WorkerAcceptCallback>(std::move(workerAcceptCallback));
+}
+
+void FramingAcceptor::setSharded(bool sharded) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    sharded_ = sharded;
+}
+
+void FramingAcceptor::setCpuSteering(bool cpuSteering) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    cpuSteering_ = cpuSteering;
+}
+
 FramingAcceptor::State FramingAcceptor::state() {
     CHECK(loop_->isInLoopThread());
 
@@ -172,17 +258,74 @@ int FramingAcceptor::open(const Endpoint &localEndpoint) {
     acceptor_->setRecvBufferMaxCapacity(recvBufferMaxCapacity_);
     acceptor_->setSendBufferMaxCapacity(sendBufferMaxCapacity_);
     acceptor_->setRecvChunkSize(recvChunkSize_);
+    acceptor_->setRecvBudget(recvBudget_);
     acceptor_->setRecvTimeout(recvTimeout_);
     acceptor_->setSendTimeout(sendTimeout_);
     acceptor_->setReuseAddr(reuseAddr_);
     acceptor_->setReusePort(reusePort_);
     acceptor_->setNoDelay(noDelay_);
     acceptor_->setKeepAlive(keepAlive_);
+    acceptor_->setBusyPoll(busyPoll_);
+    acceptor_->setEdgeTriggered(edgeTriggered_);
+    acceptor_->setZeroCopyThreshold(zeroCopyThreshold_);
+    acceptor_->setWriteCoalescing(writeCoalescing_);
+    acceptor_->setWriteCoalescingDelay(writeCoalescingDelay_);
+    acceptor_->setHighWatermark(highWatermark_);
+    acceptor_->setLowWatermark(lowWatermark_);
 
     acceptor_->addAcceptCallback([this](std::unique_ptr<Socket> socket, const Endpoint &remoteEndpoint) {
         return onAcceptorAccept(std::move(socket), remoteEndpoint);
     });
 
+    if (workerGroup_) {
+        CHECK(workerAcceptCallback_ && *workerAcceptCallback_);
+
+        acceptor_->setWorkerGroup(workerGroup_);
+        acceptor_->setSharded(sharded_);
+        acceptor_->setCpuSteering(cpuSteering_);
+        acceptor_->setWorkerAcceptCallback([workerAcceptCallback = workerAcceptCallback_,
+                                            maxMessageLength = maxMessageLength_,
+                                            recvBufferMaxCapacity = recvBufferMaxCapacity_,
+                                            sendBufferMaxCapacity = sendBufferMaxCapacity_,
+                                            recvChunkSize = recvChunkSize_,
+                                            recvBudget = recvBudget_,
+                                            recvTimeout = recvTimeout_,
+                                            sendTimeout = sendTimeout_,
+                                            noDelay = noDelay_,
+                                            keepAlive = keepAlive_,
+                                            busyPoll = busyPoll_,
+                                            edgeTriggered = edgeTriggered_,
+                                            zeroCopyThreshold = zeroCopyThreshold_,
+                                            writeCoalescing = writeCoalescing_,
+                                            writeCoalescingDelay = writeCoalescingDelay_,
+                                            highWatermark = highWatermark_,
+                                            lowWatermark = lowWatermark_](
+                                               std::unique_ptr<Socket> socket, const Endpoint &remoteEndpoint) {
+            std::unique_ptr<FramingSocket> framingSocket = std::make_unique<FramingSocket>(socket->loop());
+
+            framingSocket->setMaxMessageLength(maxMessageLength);
+            framingSocket->setRecvBufferMaxCapacity(recvBufferMaxCapacity);
+            framingSocket->setSendBufferMaxCapacity(sendBufferMaxCapacity);
+            framingSocket->setRecvChunkSize(recvChunkSize);
+            framingSocket->setRecvBudget(recvBudget);
+            framingSocket->setRecvTimeout(recvTimeout);
+            framingSocket->setSendTimeout(sendTimeout);
+            framingSocket->setNoDelay(noDelay);
+            framingSocket->setKeepAlive(keepAlive);
+            framingSocket->setBusyPoll(busyPoll);
+            framingSocket->setEdgeTriggered(edgeTriggered);
+            framingSocket->setZeroCopyThreshold(zeroCopyThreshold);
+            framingSocket->setWriteCoalescing(writeCoalescing);
+            framingSocket->setWriteCoalescingDelay(writeCoalescingDelay);
+            framingSocket->setHighWatermark(highWatermark);
+            framingSocket->setLowWatermark(lowWatermark);
+
+            framingSocket->open(std::move(socket), remoteEndpoint);
+
+            (*workerAcceptCallback)(std::move(framingSocket), remoteEndpoint);
+        });
+    }
+
     if (int error = acceptor_->open(localEndpoint)) {
         return error;
     }
@@ -247,10 +390,18 @@ bool FramingAcceptor::onAcceptorAccept(std::unique_ptr<Socket> socket, const End
     framingSocket->setRecvBufferMaxCapacity(recvBufferMaxCapacity_);
     framingSocket->setSendBufferMaxCapacity(sendBufferMaxCapacity_);
     framingSocket->setRecvChunkSize(recvChunkSize_);
+    framingSocket->setRecvBudget(recvBudget_);
     framingSocket->setRecvTimeout(recvTimeout_);
     framingSocket->setSendTimeout(sendTimeout_);
     framingSocket->setNoDelay(noDelay_);
     framingSocket->setKeepAlive(keepAlive_);
+    framingSocket->setBusyPoll(busyPoll_);
+    framingSocket->setEdgeTriggered(edgeTriggered_);
+    framingSocket->setZeroCopyThreshold(zeroCopyThreshold_);
+    framingSocket->setWriteCoalescing(writeCoalescing_);
+    framingSocket->setWriteCoalescingDelay(writeCoalescingDelay_);
+    framingSocket->setHighWatermark(highWatermark_);
+    framingSocket->setLowWatermark(lowWatermark_);
 
     framingSocket->open(std::move(socket), remoteEndpoint);
 
@@ -9,6 +9,7 @@
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <span>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -19,6 +20,8 @@
 #include "mq/utils/Check.h"
 #include "mq/utils/Endian.h"
 #include "mq/utils/Logging.h"
+#include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SharedBuffer.h"
 
 #define TAG "FramingSocket"
 
@@ -65,6 +68,13 @@ void FramingSocket::setRecvChunkSize(size_t recvChunkSize) {
     recvChunkSize_ = recvChunkSize;
 }
 
+void FramingSocket::setRecvBudget(size_t recvBudget) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    recvBudget_ = recvBudget;
+}
+
 void FramingSocket::setRecvTimeout(std::chrono::nanoseconds recvTimeout) {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kClosed);
@@ -93,6 +103,56 @@ void FramingSocket::setKeepAlive(KeepAlive keepAlive) {
     keepAlive_ = keepAlive;
 }
 
+void FramingSocket::setBusyPoll(std::chrono::microseconds busyPoll) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    busyPoll_ = busyPoll;
+}
+
+void FramingSocket::setEdgeTriggered(bool edgeTriggered) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    edgeTriggered_ = edgeTriggered;
+}
+
+void FramingSocket::setZeroCopyThreshold(size_t zeroCopyThreshold) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    zeroCopyThreshold_ = zeroCopyThreshold;
+}
+
+void FramingSocket::setWriteCoalescing(bool writeCoalescing) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    writeCoalescing_ = writeCoalescing;
+}
+
+void FramingSocket::setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+    CHECK(writeCoalescingDelay.count() >= 0);
+
+    writeCoalescingDelay_ = writeCoalescingDelay;
+}
+
+void FramingSocket::setHighWatermark(size_t highWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    highWatermark_ = highWatermark;
+}
+
+void FramingSocket::setLowWatermark(size_t lowWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    lowWatermark_ = lowWatermark;
+}
+
 FramingSocket::State FramingSocket::state() const {
     CHECK(loop_->isInLoopThread());
 
@@ -127,6 +187,14 @@ std::unique_ptr<Endpoint> FramingSocket::remoteEndpoint() const {
     return remoteEndpoint_->clone();
 }
 
+bool FramingSocket::writable() const {
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ == State::kClosed) return true;
+
+    return socket_->writable();
+}
+
 bool FramingSocket::hasConnectCallback() const {
     CHECK(loop_->isInLoopThread());
 
@@ -145,6 +213,18 @@ bool FramingSocket::hasSendCompleteCallback() const {
     return !sendCompleteCallbacks_.empty();
 }
 
+bool FramingSocket::hasHighWatermarkCallback() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !highWatermarkCallbacks_.empty();
+}
+
+bool FramingSocket::hasDrainedCallback() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !drainedCallbacks_.empty();
+}
+
 bool FramingSocket::hasCloseCallback() const {
     CHECK(loop_->isInLoopThread());
 
@@ -154,25 +234,49 @@ bool FramingSocket::hasCloseCallback() const {
 void FramingSocket::addConnectCallback(ConnectCallback connectCallback) {
     CHECK(loop_->isInLoopThread());
 
-    connectCallbacks_.emplace_back(std::move(connectCallback));
+    connectCallbacks_.add(std::move(connectCallback));
 }
 
 void FramingSocket::addRecvCallback(RecvCallback recvCallback) {
     CHECK(loop_->isInLoopThread());
 
-    recvCallbacks_.emplace_back(std::move(recvCallback));
+    recvCallbacks_.add(std::move(recvCallback));
+}
+
+CallbackId FramingSocket::addSendCompleteCallback(SendCompleteCallback sendCompleteCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    return sendCompleteCallbacks_.add(std::move(sendCompleteCallback));
+}
+
+void FramingSocket::addHighWatermarkCallback(HighWatermarkCallback highWatermarkCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    highWatermarkCallbacks_.add(std::move(highWatermarkCallback));
+}
+
+void FramingSocket::addDrainedCallback(DrainedCallback drainedCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    drainedCallbacks_.add(std::move(drainedCallback));
+}
+
+CallbackId FramingSocket::addCloseCallback(CloseCallback closeCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    return closeCallbacks_.add(std::move(closeCallback));
 }
 
-void FramingSocket::addSendCompleteCallback(SendCompleteCallback sendCompleteCallback) {
+void FramingSocket::removeSendCompleteCallback(CallbackId id) {
     CHECK(loop_->isInLoopThread());
 
-    sendCompleteCallbacks_.emplace_back(std::move(sendCompleteCallback));
+    sendCompleteCallbacks_.remove(id);
 }
 
-void FramingSocket::addCloseCallback(CloseCallback closeCallback) {
+void FramingSocket::removeCloseCallback(CallbackId id) {
     CHECK(loop_->isInLoopThread());
 
-    closeCallbacks_.emplace_back(std::move(closeCallback));
+    closeCallbacks_.remove(id);
 }
 
 void FramingSocket::clearConnectCallbacks() {
@@ -193,6 +297,18 @@ void FramingSocket::clearSendCompleteCallbacks() {
     sendCompleteCallbacks_.clear();
 }
 
+void FramingSocket::clearHighWatermarkCallbacks() {
+    CHECK(loop_->isInLoopThread());
+
+    highWatermarkCallbacks_.clear();
+}
+
+void FramingSocket::clearDrainedCallbacks() {
+    CHECK(loop_->isInLoopThread());
+
+    drainedCallbacks_.clear();
+}
+
 void FramingSocket::clearCloseCallbacks() {
     CHECK(loop_->isInLoopThread());
 
@@ -204,14 +320,7 @@ void FramingSocket::dispatchConnect(int error) {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<ConnectCallback> connectCallbacks(std::move(connectCallbacks_));
-    connectCallbacks_.clear();
-
-    for (ConnectCallback &connectCallback : connectCallbacks) {
-        if (connectCallback(error)) {
-            connectCallbacks_.emplace_back(std::move(connectCallback));
-        }
-    }
+    connectCallbacks_.dispatch(error);
 }
 
 void FramingSocket::dispatchRecv(std::string_view message) {
@@ -219,14 +328,7 @@ void FramingSocket::dispatchRecv(std::string_view message) {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<RecvCallback> recvCallbacks(std::move(recvCallbacks_));
-    recvCallbacks_.clear();
-
-    for (RecvCallback &recvCallback : recvCallbacks) {
-        if (recvCallback(message)) {
-            recvCallbacks_.emplace_back(std::move(recvCallback));
-        }
-    }
+    recvCallbacks_.dispatch(message);
 }
 
 void FramingSocket::dispatchSendComplete() {
@@ -234,14 +336,23 @@ void FramingSocket::dispatchSendComplete() {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<SendCompleteCallback> sendCompleteCallbacks(std::move(sendCompleteCallbacks_));
-    sendCompleteCallbacks_.clear();
+    sendCompleteCallbacks_.dispatch();
+}
 
-    for (SendCompleteCallback &sendCompleteCallback : sendCompleteCallbacks) {
-        if (sendCompleteCallback()) {
-            sendCompleteCallbacks_.emplace_back(std::move(sendCompleteCallback));
-        }
-    }
+void FramingSocket::dispatchHighWatermark() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    highWatermarkCallbacks_.dispatch();
+}
+
+void FramingSocket::dispatchDrained() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    drainedCallbacks_.dispatch();
 }
 
 void FramingSocket::dispatchClose(int error) {
@@ -249,14 +360,7 @@ void FramingSocket::dispatchClose(int error) {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<CloseCallback> closeCallbacks(std::move(closeCallbacks_));
-    closeCallbacks_.clear();
-
-    for (CloseCallback &closeCallback : closeCallbacks) {
-        if (closeCallback(error)) {
-            closeCallbacks_.emplace_back(std::move(closeCallback));
-        }
-    }
+    closeCallbacks_.dispatch(error);
 }
 
 void FramingSocket::open(const Endpoint &remoteEndpoint) {
@@ -270,10 +374,18 @@ void FramingSocket::open(const Endpoint &remoteEndpoint) {
     socket_->setRecvBufferMaxCapacity(recvBufferMaxCapacity_);
     socket_->setSendBufferMaxCapacity(sendBufferMaxCapacity_);
     socket_->setRecvChunkSize(recvChunkSize_);
+    socket_->setRecvBudget(recvBudget_);
     socket_->setRecvTimeout(recvTimeout_);
     socket_->setSendTimeout(sendTimeout_);
     socket_->setNoDelay(noDelay_);
     socket_->setKeepAlive(keepAlive_);
+    socket_->setBusyPoll(busyPoll_);
+    socket_->setEdgeTriggered(edgeTriggered_);
+    socket_->setZeroCopyThreshold(zeroCopyThreshold_);
+    socket_->setWriteCoalescing(writeCoalescing_);
+    socket_->setWriteCoalescingDelay(writeCoalescingDelay_);
+    socket_->setHighWatermark(highWatermark_);
+    socket_->setLowWatermark(lowWatermark_);
 
     socket_->addConnectCallback([this, remoteEndpoint = remoteEndpoint.clone()](int error) {
         if (error == 0) {
@@ -292,6 +404,12 @@ void FramingSocket::open(const Endpoint &remoteEndpoint) {
             socket_->addSendCompleteCallback([this] {
                 return onSocketSendComplete();
             });
+            socket_->addHighWatermarkCallback([this] {
+                return onSocketHighWatermark();
+            });
+            socket_->addDrainedCallback([this] {
+                return onSocketDrained();
+            });
             socket_->addCloseCallback([this](int error, const char *, size_t) {
                 return onSocketClose(error);
             });
@@ -341,12 +459,18 @@ void FramingSocket::open(std::unique_ptr<Socket> socket, const Endpoint &remoteE
     socket_->addSendCompleteCallback([this] {
         return onSocketSendComplete();
     });
+    socket_->addHighWatermarkCallback([this] {
+        return onSocketHighWatermark();
+    });
+    socket_->addDrainedCallback([this] {
+        return onSocketDrained();
+    });
     socket_->addCloseCallback([this](int error, const char *, size_t) {
         return onSocketClose(error);
     });
 }
 
-int FramingSocket::send(std::string_view message) {
+int FramingSocket::send(MaybeOwnedString message) {
     LOG(debug, "message: size={}", message.size());
 
     CHECK(loop_->isInLoopThread());
@@ -357,10 +481,15 @@ int FramingSocket::send(std::string_view message) {
     uint32_t length = static_cast<uint32_t>(message.size());
     uint32_t lengthLE = toLittleEndian(length);
 
-    return socket_->send({{reinterpret_cast<const char *>(&lengthLE), 4}, {message.data(), message.size()}});
+    MaybeOwnedString buffers[] = {
+        {reinterpret_cast<const char *>(&lengthLE), 4},
+        std::move(message),
+    };
+
+    return socket_->send(buffers);
 }
 
-int FramingSocket::send(const std::vector<std::string_view> &pieces) {
+int FramingSocket::send(std::span<const std::string_view> pieces) {
     LOG(debug, "");
 
     CHECK(loop_->isInLoopThread());
@@ -374,10 +503,24 @@ int FramingSocket::send(const std::vector<std::string_view> &pieces) {
 
     CHECK(length <= maxMessageLength_);
 
+    uint32_t lengthLE = toLittleEndian(static_cast<uint32_t>(length));
+
+    constexpr size_t kMaxInlineBuffers = 16;
+
+    if (pieces.size() < kMaxInlineBuffers) {
+        std::pair<const char *, size_t> buffers[kMaxInlineBuffers];
+        buffers[0] = {reinterpret_cast<const char *>(&lengthLE), 4};
+
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            buffers[i + 1] = {pieces[i].data(), pieces[i].size()};
+        }
+
+        return socket_->send(std::span(buffers, 1 + pieces.size()));
+    }
+
     std::vector<std::pair<const char *, size_t>> buffers;
     buffers.reserve(1 + pieces.size());
 
-    uint32_t lengthLE = toLittleEndian(static_cast<uint32_t>(length));
     buffers.emplace_back(reinterpret_cast<const char *>(&lengthLE), 4);
 
     for (std::string_view piece : pieces) {
@@ -387,6 +530,109 @@ int FramingSocket::send(const std::vector<std::string_view> &pieces) {
     return socket_->send(buffers);
 }
 
+int FramingSocket::send(std::span<MaybeOwnedString> pieces) {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected) return ENOTCONN;
+
+    size_t length = 0;
+    for (const MaybeOwnedString &piece : pieces) {
+        length += piece.size();
+    }
+
+    CHECK(length <= maxMessageLength_);
+
+    uint32_t lengthLE = toLittleEndian(static_cast<uint32_t>(length));
+
+    constexpr size_t kMaxInlineBuffers = 16;
+
+    if (pieces.size() < kMaxInlineBuffers) {
+        MaybeOwnedString buffers[kMaxInlineBuffers];
+        buffers[0] = {reinterpret_cast<const char *>(&lengthLE), 4};
+
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            buffers[i + 1] = std::move(pieces[i]);
+        }
+
+        return socket_->send(std::span(buffers, 1 + pieces.size()));
+    }
+
+    std::vector<MaybeOwnedString> buffers;
+    buffers.reserve(1 + pieces.size());
+
+    buffers.emplace_back(reinterpret_cast<const char *>(&lengthLE), 4);
+
+    for (MaybeOwnedString &piece : pieces) {
+        buffers.push_back(std::move(piece));
+    }
+
+    return socket_->send(buffers);
+}
+
+int FramingSocket::sendFrame(SharedBuffer frame) {
+    LOG(debug, "frame: size={}", frame.size());
+
+    CHECK(loop_->isInLoopThread());
+    CHECK(frame.size() >= 4 && frame.size() - 4 <= maxMessageLength_);
+
+    if (state_ != State::kConnected) return ENOTCONN;
+
+    MaybeOwnedString buffers[] = {std::move(frame)};
+
+    return socket_->send(buffers);
+}
+
+int FramingSocket::sendFrames(std::span<const SharedBuffer> frames) {
+    LOG(debug, "frames: size={}", frames.size());
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected) return ENOTCONN;
+
+    std::vector<MaybeOwnedString> buffers;
+    buffers.reserve(frames.size());
+
+    for (const SharedBuffer &frame : frames) {
+        CHECK(frame.size() >= 4 && frame.size() - 4 <= maxMessageLength_);
+
+        buffers.emplace_back(frame);
+    }
+
+    return socket_->send(buffers);
+}
+
+void FramingSocket::flush() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected) return;
+
+    socket_->flush();
+}
+
+void FramingSocket::pauseRecv() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected) return;
+
+    socket_->pauseRecv();
+}
+
+void FramingSocket::resumeRecv() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected) return;
+
+    socket_->resumeRecv();
+}
+
 void FramingSocket::close(int error) {
     LOG(debug, "error={}", strerrorname_np(error));
 
@@ -398,6 +644,8 @@ void FramingSocket::close(int error) {
     state_ = State::kClosed;
     LOG(debug, "{} -> {}", oldState, state_);
 
+    bool drained = !socket_->writable();
+
     socket_->reset();
 
     loop_->post([socket = std::move(socket_)] {});
@@ -407,6 +655,10 @@ void FramingSocket::close(int error) {
     localEndpoint_ = nullptr;
     remoteEndpoint_ = nullptr;
 
+    if (drained) {
+        dispatchDrained();
+    }
+
     dispatchClose(error);
 }
 
@@ -418,6 +670,8 @@ void FramingSocket::reset() {
     clearConnectCallbacks();
     clearRecvCallbacks();
     clearSendCompleteCallbacks();
+    clearHighWatermarkCallbacks();
+    clearDrainedCallbacks();
     clearCloseCallbacks();
 
     if (state_ == State::kClosed) return;
@@ -436,6 +690,37 @@ void FramingSocket::reset() {
     remoteEndpoint_ = nullptr;
 }
 
+SharedBuffer FramingSocket::frame(std::string_view message) {
+    SharedBuffer frame(4 + message.size());
+
+    uint32_t lengthLE = toLittleEndian(static_cast<uint32_t>(message.size()));
+    memcpy(frame.mutableData(), &lengthLE, 4);
+    memcpy(frame.mutableData() + 4, message.data(), message.size());
+
+    return frame;
+}
+
+SharedBuffer FramingSocket::frame(std::span<const MaybeOwnedString> pieces) {
+    size_t length = 0;
+    for (const MaybeOwnedString &piece : pieces) {
+        length += piece.size();
+    }
+
+    SharedBuffer frame(4 + length);
+
+    uint32_t lengthLE = toLittleEndian(static_cast<uint32_t>(length));
+    memcpy(frame.mutableData(), &lengthLE, 4);
+
+    char *data = frame.mutableData() + 4;
+
+    for (const MaybeOwnedString &piece : pieces) {
+        memcpy(data, piece.data(), piece.size());
+        data += piece.size();
+    }
+
+    return frame;
+}
+
 bool FramingSocket::onSocketRecv(const char *data, size_t size, size_t &newSize) {
     LOG(debug, "");
 
@@ -476,6 +761,22 @@ bool FramingSocket::onSocketSendComplete() {
     return true;
 }
 
+bool FramingSocket::onSocketHighWatermark() {
+    LOG(debug, "");
+
+    dispatchHighWatermark();
+
+    return true;
+}
+
+bool FramingSocket::onSocketDrained() {
+    LOG(debug, "");
+
+    dispatchDrained();
+
+    return true;
+}
+
 bool FramingSocket::onSocketClose(int error) {
     LOG(debug, "");
 
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -359,7 +360,7 @@ int ReadLineSocket::send(const char *data, size_t size) {
     return socket_->send(data, size);
 }
 
-int ReadLineSocket::send(const std::vector<std::pair<const char *, size_t>> &buffers) {
+int ReadLineSocket::send(std::span<const std::pair<const char *, size_t>> buffers) {
     LOG(debug, "buffers: size={}", buffers.size());
 
     CHECK(loop_->isInLoopThread());
@@ -5,13 +5,17 @@
 #include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <climits>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <span>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <linux/errqueue.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
@@ -28,6 +32,8 @@
 #include "mq/utils/Buffer.h"
 #include "mq/utils/Check.h"
 #include "mq/utils/Logging.h"
+#include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SendQueue.h"
 
 #define TAG "Socket"
 
@@ -35,6 +41,16 @@ using namespace mq;
 
 namespace {
 
+constexpr size_t kMinRecvChunkSize = 512;
+constexpr size_t kMaxRecvChunkSize = 65536;
+constexpr size_t kRecvExtraSize = 65536;
+constexpr int kRecvShrinkThreshold = 2;
+constexpr size_t kMaxInlineIovecs = 64;
+constexpr size_t kMaxIovecs = IOV_MAX;
+constexpr size_t kMaxCoalescedSize = 65536;
+constexpr std::chrono::milliseconds kZeroCopyLingerInterval(10);
+constexpr std::chrono::seconds kZeroCopyLingerTimeout(5);
+
 std::unique_ptr<Endpoint> getSockName(int fd) {
     int optVal;
     socklen_t optLen = sizeof(optVal);
@@ -90,13 +106,124 @@ void setKeepAliveSockOpt(int fd, const KeepAlive &keepAlive) {
     }
 }
 
+void setBusyPollSockOpt(int fd, std::chrono::microseconds busyPoll) {
+    int optVal = busyPoll.count();
+    if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &optVal, sizeof(optVal)) != 0) {
+        LOG(warning, "setsockopt: fd={}, SO_BUSY_POLL, errno={}", fd, strerrorname_np(errno));
+    }
+}
+
+bool setZeroCopySockOpt(int fd) {
+    int optVal = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &optVal, sizeof(optVal)) != 0) {
+        LOG(warning, "setsockopt: fd={}, SO_ZEROCOPY, errno={}", fd, strerrorname_np(errno));
+        return false;
+    }
+
+    return true;
+}
+
+// Reads zero-copy completion notifications from the error queue of fd and calls onCompletion(err) for
+// each. Returns true if anything was read.
+template <typename OnCompletion>
+bool readZeroCopyCompletions(int fd, OnCompletion onCompletion) {
+    bool drained = false;
+
+    for (;;) {
+        char control[256];
+
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) {
+            if (errno == EINTR) continue;
+
+            LOG(debug, "recvmsg: errno={}", strerrorname_np(errno));
+
+            return drained;
+        }
+
+        drained = true;
+
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+                !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+
+            sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+
+            if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+            LOG(debug, "zeroCopy: lo={}, hi={}, code={}", err.ee_info, err.ee_data, err.ee_code);
+
+            onCompletion(err);
+        }
+    }
+}
+
+struct ZeroCopyLinger {
+    EventLoop *loop;
+    int fd;
+    std::unique_ptr<SendQueue> retired;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+std::unique_ptr<ZeroCopyLinger> makeZeroCopyLinger(EventLoop *loop, int fd, SendQueue &sendQueue) {
+    auto linger = std::make_unique<ZeroCopyLinger>();
+    linger->loop = loop;
+    linger->fd = fd;
+    linger->retired = std::make_unique<SendQueue>();
+    linger->deadline = std::chrono::steady_clock::now() + kZeroCopyLingerTimeout;
+
+    sendQueue.moveRetiredTo(*linger->retired);
+
+    return linger;
+}
+
+// Closes the fd once the kernel has released every retired zero-copy segment, polling its error queue.
+// If the data is not acknowledged before the deadline, the connection is reset instead of closed
+// gracefully, so that the kernel drops its references before the segments are freed.
+void closeAfterZeroCopy(std::unique_ptr<ZeroCopyLinger> linger) {
+    if (linger->retired->numRetiredSegments() > 0) {
+        readZeroCopyCompletions(linger->fd, [&linger](const sock_extended_err &err) {
+            linger->retired->releaseZeroCopy(err.ee_data);
+        });
+    }
+
+    if (linger->retired->numRetiredSegments() > 0) {
+        if (std::chrono::steady_clock::now() < linger->deadline) {
+            EventLoop *loop = linger->loop;
+
+            loop->postTimed([linger = std::move(linger)] mutable {
+                closeAfterZeroCopy(std::move(linger));
+            }, kZeroCopyLingerInterval);
+
+            return;
+        }
+
+        LOG(warning, "fd={}, zero-copy linger timed out, numRetiredSegments={}",
+            linger->fd, linger->retired->numRetiredSegments());
+
+        ::linger optVal{1, 0};
+        CHECK(setsockopt(linger->fd, SOL_SOCKET, SO_LINGER, &optVal, sizeof(optVal)) == 0);
+    }
+
+    CHECK(::close(linger->fd) == 0);
+}
+
 } // namespace
 
 Socket::Socket(EventLoop *loop)
     : loop_(loop),
       recvBuffer_(16 * 1024 * 1024),
-      sendBuffer_(16 * 1024 * 1024) {
+      sendQueue_(16 * 1024 * 1024) {
     LOG(debug, "");
+
+    recvBuffer_.setPool(loop_->bufferPool());
+    sendQueue_.setPool(loop_->bufferPool());
 }
 
 Socket::~Socket() {
@@ -118,7 +245,7 @@ void Socket::setSendBufferMaxCapacity(size_t sendBufferMaxCapacity) {
     CHECK(loop_->isInLoopThread());
     CHECK(state_ == State::kClosed);
 
-    sendBuffer_.setMaxCapacity(sendBufferMaxCapacity);
+    sendQueue_.setMaxSize(sendBufferMaxCapacity);
 }
 
 void Socket::setRecvChunkSize(size_t recvChunkSize) {
@@ -126,6 +253,15 @@ void Socket::setRecvChunkSize(size_t recvChunkSize) {
     CHECK(state_ == State::kClosed);
 
     recvChunkSize_ = recvChunkSize;
+    adaptiveRecvChunkSize_ = recvChunkSize;
+    recvShrinkCount_ = 0;
+}
+
+void Socket::setRecvBudget(size_t recvBudget) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    recvBudget_ = recvBudget;
 }
 
 void Socket::setRecvTimeout(std::chrono::nanoseconds recvTimeout) {
@@ -156,6 +292,56 @@ void Socket::setKeepAlive(KeepAlive keepAlive) {
     keepAlive_ = keepAlive;
 }
 
+void Socket::setBusyPoll(std::chrono::microseconds busyPoll) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    busyPoll_ = busyPoll;
+}
+
+void Socket::setEdgeTriggered(bool edgeTriggered) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    edgeTriggered_ = edgeTriggered;
+}
+
+void Socket::setZeroCopyThreshold(size_t zeroCopyThreshold) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    zeroCopyThreshold_ = zeroCopyThreshold;
+}
+
+void Socket::setWriteCoalescing(bool writeCoalescing) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    writeCoalescing_ = writeCoalescing;
+}
+
+void Socket::setWriteCoalescingDelay(std::chrono::nanoseconds writeCoalescingDelay) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+    CHECK(writeCoalescingDelay.count() >= 0);
+
+    writeCoalescingDelay_ = writeCoalescingDelay;
+}
+
+void Socket::setHighWatermark(size_t highWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    highWatermark_ = highWatermark;
+}
+
+void Socket::setLowWatermark(size_t lowWatermark) {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kClosed);
+
+    lowWatermark_ = lowWatermark;
+}
+
 Socket::State Socket::state() const {
     CHECK(loop_->isInLoopThread());
 
@@ -197,6 +383,53 @@ std::unique_ptr<Endpoint> Socket::remoteEndpoint() const {
     return remoteEndpoint_->clone();
 }
 
+int Socket::incomingCpu() const {
+    CHECK(loop_->isInLoopThread());
+    CHECK(state_ == State::kConnected);
+
+    int optVal;
+    socklen_t optLen = sizeof(optVal);
+    if (getsockopt(fd_, SOL_SOCKET, SO_INCOMING_CPU, &optVal, &optLen) < 0) {
+        LOG(debug, "getsockopt: errno={}", strerrorname_np(errno));
+        return -1;
+    }
+
+    return optVal;
+}
+
+size_t Socket::sendBufferSize() const {
+    CHECK(loop_->isInLoopThread());
+
+    return sendQueue_.size();
+}
+
+bool Socket::writable() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !aboveHighWatermark_;
+}
+
+bool Socket::recvPaused() const {
+    CHECK(loop_->isInLoopThread());
+
+    return recvPaused_;
+}
+
+Socket::Stats Socket::stats() const {
+    CHECK(loop_->isInLoopThread());
+
+    Stats stats = stats_;
+    stats.recvChunkSize = adaptiveRecvChunkSize_;
+
+    return stats;
+}
+
+void Socket::resetStats() {
+    CHECK(loop_->isInLoopThread());
+
+    stats_ = Stats();
+}
+
 bool Socket::hasConnectCallback() const {
     CHECK(loop_->isInLoopThread());
 
@@ -215,6 +448,18 @@ bool Socket::hasSendCompleteCallback() const {
     return !sendCompleteCallbacks_.empty();
 }
 
+bool Socket::hasHighWatermarkCallback() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !highWatermarkCallbacks_.empty();
+}
+
+bool Socket::hasDrainedCallback() const {
+    CHECK(loop_->isInLoopThread());
+
+    return !drainedCallbacks_.empty();
+}
+
 bool Socket::hasCloseCallback() const {
     CHECK(loop_->isInLoopThread());
 
@@ -224,25 +469,37 @@ bool Socket::hasCloseCallback() const {
 void Socket::addConnectCallback(ConnectCallback connectCallback) {
     CHECK(loop_->isInLoopThread());
 
-    connectCallbacks_.emplace_back(std::move(connectCallback));
+    connectCallbacks_.add(std::move(connectCallback));
 }
 
 void Socket::addRecvCallback(RecvCallback recvCallback) {
     CHECK(loop_->isInLoopThread());
 
-    recvCallbacks_.emplace_back(std::move(recvCallback));
+    recvCallbacks_.add(std::move(recvCallback));
 }
 
 void Socket::addSendCompleteCallback(SendCompleteCallback sendCompleteCallback) {
     CHECK(loop_->isInLoopThread());
 
-    sendCompleteCallbacks_.emplace_back(std::move(sendCompleteCallback));
+    sendCompleteCallbacks_.add(std::move(sendCompleteCallback));
+}
+
+void Socket::addHighWatermarkCallback(HighWatermarkCallback highWatermarkCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    highWatermarkCallbacks_.add(std::move(highWatermarkCallback));
+}
+
+void Socket::addDrainedCallback(DrainedCallback drainedCallback) {
+    CHECK(loop_->isInLoopThread());
+
+    drainedCallbacks_.add(std::move(drainedCallback));
 }
 
 void Socket::addCloseCallback(CloseCallback closeCallback) {
     CHECK(loop_->isInLoopThread());
 
-    closeCallbacks_.emplace_back(std::move(closeCallback));
+    closeCallbacks_.add(std::move(closeCallback));
 }
 
 void Socket::clearConnectCallbacks() {
@@ -263,6 +520,18 @@ void Socket::clearSendCompleteCallbacks() {
     sendCompleteCallbacks_.clear();
 }
 
+void Socket::clearHighWatermarkCallbacks() {
+    CHECK(loop_->isInLoopThread());
+
+    highWatermarkCallbacks_.clear();
+}
+
+void Socket::clearDrainedCallbacks() {
+    CHECK(loop_->isInLoopThread());
+
+    drainedCallbacks_.clear();
+}
+
 void Socket::clearCloseCallbacks() {
     CHECK(loop_->isInLoopThread());
 
@@ -274,14 +543,7 @@ void Socket::dispatchConnect(int error) {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<ConnectCallback> connectCallbacks(std::move(connectCallbacks_));
-    connectCallbacks_.clear();
-
-    for (ConnectCallback &connectCallback : connectCallbacks) {
-        if (connectCallback(error)) {
-            connectCallbacks_.emplace_back(std::move(connectCallback));
-        }
-    }
+    connectCallbacks_.dispatch(error);
 }
 
 void Socket::dispatchRecv(const char *data, size_t size, size_t &newSize) {
@@ -289,14 +551,7 @@ void Socket::dispatchRecv(const char *data, size_t size, size_t &newSize) {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<RecvCallback> recvCallbacks(std::move(recvCallbacks_));
-    recvCallbacks_.clear();
-
-    for (RecvCallback &recvCallback : recvCallbacks) {
-        if (recvCallback(data, size, newSize)) {
-            recvCallbacks_.emplace_back(std::move(recvCallback));
-        }
-    }
+    recvCallbacks_.dispatch(data, size, newSize);
 }
 
 void Socket::dispatchSendComplete() {
@@ -304,14 +559,23 @@ void Socket::dispatchSendComplete() {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<SendCompleteCallback> sendCompleteCallbacks(std::move(sendCompleteCallbacks_));
-    sendCompleteCallbacks_.clear();
+    sendCompleteCallbacks_.dispatch();
+}
 
-    for (SendCompleteCallback &sendCompleteCallback : sendCompleteCallbacks) {
-        if (sendCompleteCallback()) {
-            sendCompleteCallbacks_.emplace_back(std::move(sendCompleteCallback));
-        }
-    }
+void Socket::dispatchHighWatermark() {
+    LOG(debug, "size={}", sendQueue_.size());
+
+    CHECK(loop_->isInLoopThread());
+
+    highWatermarkCallbacks_.dispatch();
+}
+
+void Socket::dispatchDrained() {
+    LOG(debug, "size={}", sendQueue_.size());
+
+    CHECK(loop_->isInLoopThread());
+
+    drainedCallbacks_.dispatch();
 }
 
 void Socket::dispatchClose(int error, const char *data, size_t size) {
@@ -319,14 +583,7 @@ void Socket::dispatchClose(int error, const char *data, size_t size) {
 
     CHECK(loop_->isInLoopThread());
 
-    std::vector<CloseCallback> closeCallbacks(std::move(closeCallbacks_));
-    closeCallbacks_.clear();
-
-    for (CloseCallback &closeCallback : closeCallbacks) {
-        if (closeCallback(error, data, size)) {
-            closeCallbacks_.emplace_back(std::move(closeCallback));
-        }
-    }
+    closeCallbacks_.dispatch(error, data, size);
 }
 
 void Socket::open(const Endpoint &remoteEndpoint) {
@@ -345,9 +602,18 @@ void Socket::open(const Endpoint &remoteEndpoint) {
         if (keepAlive_) {
             setKeepAliveSockOpt(fd_, keepAlive_);
         }
+        if (busyPoll_.count() > 0) {
+            setBusyPollSockOpt(fd_, busyPoll_);
+        }
+        if (zeroCopyThreshold_ > 0) {
+            zeroCopy_ = setZeroCopySockOpt(fd_);
+            zeroCopyId_ = 0;
+        }
     }
 
     watcher_ = std::make_unique<Watcher>(loop_, fd_);
+    watcher_->setTag(TAG);
+    watcher_->setEdgeTriggered(edgeTriggered_);
     watcher_->registerSelf();
 
     if (connect(fd_, remoteEndpoint.data(), remoteEndpoint.size()) == 0) {
@@ -473,11 +739,20 @@ void Socket::open(int fd, const Endpoint &remoteEndpoint) {
         if (keepAlive_) {
             setKeepAliveSockOpt(fd, keepAlive_);
         }
+        if (busyPoll_.count() > 0) {
+            setBusyPollSockOpt(fd, busyPoll_);
+        }
+        if (zeroCopyThreshold_ > 0) {
+            zeroCopy_ = setZeroCopySockOpt(fd);
+            zeroCopyId_ = 0;
+        }
     }
 
     fd_ = fd;
 
     watcher_ = std::make_unique<Watcher>(loop_, fd_);
+    watcher_->setTag(TAG);
+    watcher_->setEdgeTriggered(edgeTriggered_);
     watcher_->registerSelf();
 
     localEndpoint_ = getSockName(fd_);
@@ -514,22 +789,41 @@ int Socket::send(const char *data, size_t size) {
     if (state_ != State::kConnected) return ENOTCONN;
 
     if (size > 0) {
-        if (sendBuffer_.maxCapacity() - sendBuffer_.size() < size) {
+        if (sendQueue_.maxSize() - sendQueue_.size() < size) {
             return ENOBUFS;
         }
 
-        if (sendBuffer_.empty()) {
+        if (writeCoalescing_) {
+            bool wasEmpty = sendQueue_.empty();
+
+            sendQueue_.append(data, size);
+            ++stats_.coalescedSends;
+
+            if (wasEmpty || flushPending_) {
+                scheduleFlush();
+            }
+
+            checkHighWatermark();
+
+            return 0;
+        }
+
+        if (sendQueue_.empty()) {
             while (size > 0) {
                 ssize_t n = ::send(fd_, data, size, MSG_NOSIGNAL);
 
                 if (n >= 0) {
+                    recordSend(n);
                     data += n;
                     size -= n;
                 } else {
                     LOG(debug, "send: errno={}", strerrorname_np(errno));
 
                     if (errno == EINTR) continue;
-                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        watcher_->clearWriteReady();
+                        break;
+                    }
 
                     close(errno);
 
@@ -539,13 +833,13 @@ int Socket::send(const char *data, size_t size) {
         }
 
         if (size > 0) {
-            sendBuffer_.extend(size);
+            sendQueue_.append(data, size);
 
-            memcpy(sendBuffer_.data() + sendBuffer_.size() - size, data, size);
-
-            if (sendBuffer_.size() == size) {
+            if (sendQueue_.size() == size) {
                 watcher_->addWriteReadyCallback([this] { return onWatcherWriteReady(); });
             }
+
+            checkHighWatermark();
         }
     } else {
         dispatchSendComplete();
@@ -554,7 +848,7 @@ int Socket::send(const char *data, size_t size) {
     return 0;
 }
 
-int Socket::send(const std::vector<std::pair<const char *, size_t>> &buffers) {
+int Socket::send(std::span<const std::pair<const char *, size_t>> buffers) {
     LOG(debug, "");
 
     CHECK(loop_->isInLoopThread());
@@ -567,60 +861,157 @@ int Socket::send(const std::vector<std::pair<const char *, size_t>> &buffers) {
     }
 
     if (totalSize > 0) {
-        if (sendBuffer_.maxCapacity() - sendBuffer_.size() < totalSize) {
+        if (sendQueue_.maxSize() - sendQueue_.size() < totalSize) {
             return ENOBUFS;
         }
 
-        size_t remainingSize = totalSize;
+        if (writeCoalescing_) {
+            bool wasEmpty = sendQueue_.empty();
 
-        if (sendBuffer_.empty()) {
-            std::vector<iovec> iovs;
-            iovs.reserve(buffers.size());
             for (auto [data, size] : buffers) {
-                iovs.emplace_back(static_cast<void *>(const_cast<char *>(data)), size);
+                sendQueue_.append(data, size);
             }
+            ++stats_.coalescedSends;
 
-            msghdr msg{};
-            msg.msg_iov = iovs.data();
-            msg.msg_iovlen = iovs.size();
+            if (wasEmpty || flushPending_) {
+                scheduleFlush();
+            }
 
-            ssize_t n = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+            checkHighWatermark();
 
-            if (n >= 0) {
-                remainingSize -= n;
-            } else {
-                LOG(debug, "sendmsg: errno={}", strerrorname_np(errno));
+            return 0;
+        }
 
-                if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
-                    close(errno);
+        size_t remainingSize = totalSize;
 
-                    return 0;
-                }
+        if (sendQueue_.empty()) {
+            iovec iovs[kMaxInlineIovecs];
+            size_t numIovecs = std::min(buffers.size(), kMaxInlineIovecs);
+            for (size_t i = 0; i < numIovecs; ++i) {
+                iovs[i].iov_base = const_cast<char *>(buffers[i].first);
+                iovs[i].iov_len = buffers[i].second;
             }
+
+            size_t sentSize;
+            if (!sendDirect(iovs, numIovecs, sentSize)) return 0;
+
+            remainingSize -= sentSize;
         }
 
         if (remainingSize > 0) {
-            sendBuffer_.reserve(remainingSize);
-
             size_t offset = totalSize - remainingSize;
 
             for (auto [data, size] : buffers) {
                 if (offset >= size) {
                     offset -= size;
                 } else {
-                    data += offset;
-                    size -= offset;
+                    sendQueue_.append(data + offset, size - offset);
+                    offset = 0;
+                }
+            }
+
+            if (sendQueue_.size() == remainingSize) {
+                watcher_->addWriteReadyCallback([this] { return onWatcherWriteReady(); });
+            }
+
+            checkHighWatermark();
+        }
+    } else {
+        dispatchSendComplete();
+    }
+
+    return 0;
+}
+
+int Socket::send(std::span<MaybeOwnedString> pieces) {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected) return ENOTCONN;
+
+    size_t totalSize = 0;
+    for (const MaybeOwnedString &piece : pieces) {
+        totalSize += piece.size();
+    }
+
+    if (totalSize > 0) {
+        if (sendQueue_.maxSize() - sendQueue_.size() < totalSize) {
+            return ENOBUFS;
+        }
+
+        if (writeCoalescing_) {
+            bool wasEmpty = sendQueue_.empty();
+
+            for (MaybeOwnedString &piece : pieces) {
+                sendQueue_.append(std::move(piece));
+            }
+            ++stats_.coalescedSends;
 
-                    sendBuffer_.extend(size);
-                    memcpy(sendBuffer_.data() + sendBuffer_.size() - size, data, size);
+            if (wasEmpty || flushPending_) {
+                scheduleFlush();
+            }
+
+            checkHighWatermark();
+
+            return 0;
+        }
+
+        if (zeroCopy_ && totalSize >= zeroCopyThreshold_) {
+            bool wasEmpty = sendQueue_.empty();
+
+            for (MaybeOwnedString &piece : pieces) {
+                sendQueue_.append(std::move(piece));
+            }
+
+            if (wasEmpty) {
+                if (!flushSendQueue()) return 0;
+
+                if (!sendQueue_.empty()) {
+                    watcher_->addWriteReadyCallback([this] { return onWatcherWriteReady(); });
+                }
+            }
+
+            checkHighWatermark();
+
+            return 0;
+        }
 
+        size_t remainingSize = totalSize;
+
+        if (sendQueue_.empty()) {
+            iovec iovs[kMaxInlineIovecs];
+            size_t numIovecs = std::min(pieces.size(), kMaxInlineIovecs);
+            for (size_t i = 0; i < numIovecs; ++i) {
+                iovs[i].iov_base = const_cast<char *>(pieces[i].data());
+                iovs[i].iov_len = pieces[i].size();
+            }
+
+            size_t sentSize;
+            if (!sendDirect(iovs, numIovecs, sentSize)) return 0;
+
+            remainingSize -= sentSize;
+        }
+
+        if (remainingSize > 0) {
+            size_t offset = totalSize - remainingSize;
+
+            for (MaybeOwnedString &piece : pieces) {
+                size_t size = piece.size();
+
+                if (offset >= size) {
+                    offset -= size;
+                } else {
+                    sendQueue_.append(std::move(piece), offset);
                     offset = 0;
                 }
             }
 
-            if (sendBuffer_.size() == remainingSize) {
+            if (sendQueue_.size() == remainingSize) {
                 watcher_->addWriteReadyCallback([this] { return onWatcherWriteReady(); });
             }
+
+            checkHighWatermark();
         }
     } else {
         dispatchSendComplete();
@@ -629,6 +1020,60 @@ int Socket::send(const std::vector<std::pair<const char *, size_t>> &buffers) {
     return 0;
 }
 
+void Socket::flush() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (!flushPending_) return;
+
+    flushPending_ = false;
+
+    if (flushTimer_) {
+        flushTimer_->cancel();
+    }
+
+    ++stats_.flushes;
+
+    if (!flushSendQueue()) return;
+
+    sendActive_ = true;
+
+    if (sendQueue_.empty()) {
+        dispatchSendComplete();
+    } else {
+        watcher_->addWriteReadyCallback([this] { return onWatcherWriteReady(); });
+    }
+
+    checkLowWatermark();
+}
+
+void Socket::pauseRecv() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected || recvPaused_) return;
+
+    recvPaused_ = true;
+
+    watcher_->clearReadReadyCallbacks();
+    watcher_->addErrorCallback([this] { return onWatcherError(); });
+}
+
+void Socket::resumeRecv() {
+    LOG(debug, "");
+
+    CHECK(loop_->isInLoopThread());
+
+    if (state_ != State::kConnected || !recvPaused_) return;
+
+    recvPaused_ = false;
+
+    watcher_->clearErrorCallbacks();
+    watcher_->addReadReadyCallback([this] { return onWatcherReadReady(); });
+}
+
 void Socket::close(int error) {
     LOG(debug, "error={}", strerrorname_np(error));
 
@@ -644,6 +1089,8 @@ void Socket::close(int error) {
 
     watcher_->clearReadReadyCallbacks();
     watcher_->clearWriteReadyCallbacks();
+    watcher_->clearFlushCallbacks();
+    watcher_->clearErrorCallbacks();
 
     if (recvTimeout_.count() > 0) {
         recvTimer_->reset();
@@ -653,26 +1100,45 @@ void Socket::close(int error) {
         sendTimer_->reset();
     }
 
+    if (flushTimer_) {
+        flushTimer_->reset();
+    }
+
+    // Taken before the linger retires the segments that a zero-copy send has partly handed to the kernel.
+    std::string unsent = sendQueue_.toString();
+
     loop_->post([recvTimer = std::move(recvTimer_),
                  sendTimer = std::move(sendTimer_),
+                 flushTimer = std::move(flushTimer_),
                  watcher = std::move(watcher_),
-                 fd = fd_] {
+                 linger = makeZeroCopyLinger(loop_, fd_, sendQueue_)] mutable {
         watcher->unregisterSelf();
 
-        CHECK(::close(fd) == 0);
+        closeAfterZeroCopy(std::move(linger));
     });
 
     watcher_ = nullptr;
     recvTimer_ = nullptr;
     sendTimer_ = nullptr;
+    flushTimer_ = nullptr;
+    flushPending_ = false;
+    recvPaused_ = false;
 
     localEndpoint_ = nullptr;
     remoteEndpoint_ = nullptr;
 
-    dispatchClose(error, sendBuffer_.data(), sendBuffer_.size());
+    zeroCopy_ = false;
+
+    if (aboveHighWatermark_) {
+        aboveHighWatermark_ = false;
+
+        dispatchDrained();
+    }
+
+    dispatchClose(error, unsent.data(), unsent.size());
 
     recvBuffer_.clear();
-    sendBuffer_.clear();
+    sendQueue_.clear();
 }
 
 void Socket::reset() {
@@ -680,15 +1146,18 @@ void Socket::reset() {
 
     CHECK(loop_->isInLoopThread());
 
-    recvBuffer_.clear();
-    sendBuffer_.clear();
-
     clearConnectCallbacks();
     clearRecvCallbacks();
     clearSendCompleteCallbacks();
+    clearHighWatermarkCallbacks();
+    clearDrainedCallbacks();
     clearCloseCallbacks();
 
-    if (state_ == State::kClosed) return;
+    if (state_ == State::kClosed) {
+        recvBuffer_.clear();
+        sendQueue_.clear();
+        return;
+    }
 
     State oldState = state_;
     state_ = State::kClosed;
@@ -696,6 +1165,8 @@ void Socket::reset() {
 
     watcher_->clearReadReadyCallbacks();
     watcher_->clearWriteReadyCallbacks();
+    watcher_->clearFlushCallbacks();
+    watcher_->clearErrorCallbacks();
 
     if (recvTimeout_.count() > 0) {
         recvTimer_->reset();
@@ -705,26 +1176,206 @@ void Socket::reset() {
         sendTimer_->reset();
     }
 
+    if (flushTimer_) {
+        flushTimer_->reset();
+    }
+
     loop_->post([recvTimer = std::move(recvTimer_),
                  sendTimer = std::move(sendTimer_),
+                 flushTimer = std::move(flushTimer_),
                  watcher = std::move(watcher_),
-                 fd = fd_] {
+                 linger = makeZeroCopyLinger(loop_, fd_, sendQueue_)] mutable {
         watcher->unregisterSelf();
 
-        CHECK(::close(fd) == 0);
+        closeAfterZeroCopy(std::move(linger));
     });
 
     watcher_ = nullptr;
     recvTimer_ = nullptr;
     sendTimer_ = nullptr;
+    flushTimer_ = nullptr;
+    flushPending_ = false;
+    recvPaused_ = false;
+    aboveHighWatermark_ = false;
 
     localEndpoint_ = nullptr;
     remoteEndpoint_ = nullptr;
+
+    recvBuffer_.clear();
+    sendQueue_.clear();
+}
+
+bool Socket::sendDirect(iovec *iovs, size_t numIovecs, size_t &sentSize) {
+    msghdr msg{};
+    msg.msg_iov = iovs;
+    msg.msg_iovlen = numIovecs;
+
+    for (;;) {
+        ssize_t n = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+        LOG(debug, "sendmsg: n={}", n);
+
+        if (n >= 0) {
+            recordSend(n);
+            sentSize = n;
+
+            return true;
+        }
+
+        LOG(debug, "sendmsg: errno={}", strerrorname_np(errno));
+
+        if (errno == EINTR) continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            watcher_->clearWriteReady();
+            sentSize = 0;
+
+            return true;
+        }
+
+        close(errno);
+
+        return false;
+    }
+}
+
+bool Socket::flushSendQueue() {
+    iovec iovs[kMaxIovecs];
+
+    msghdr msg{};
+    msg.msg_iov = iovs;
+    msg.msg_iovlen = sendQueue_.fill(iovs, kMaxIovecs);
+
+    bool zeroCopy = zeroCopy_ && sendQueue_.size() >= zeroCopyThreshold_;
+
+    for (;;) {
+        ssize_t n = sendmsg(fd_, &msg, MSG_NOSIGNAL | (zeroCopy ? MSG_ZEROCOPY : 0));
+        LOG(debug, "sendmsg: n={}, zeroCopy={}", n, zeroCopy);
+
+        if (n > 0 && zeroCopy) {
+            recordSend(n);
+            ++stats_.zeroCopySends;
+            sendQueue_.consumeZeroCopy(n, zeroCopyId_++);
+
+            return true;
+        }
+
+        if (n >= 0) {
+            recordSend(n);
+            sendQueue_.consume(n);
+
+            return true;
+        }
+
+        LOG(debug, "sendmsg: errno={}", strerrorname_np(errno));
+
+        if (errno == EINTR) continue;
+
+        if (errno == ENOBUFS && zeroCopy) {
+            zeroCopy = false;
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            watcher_->clearWriteReady();
+
+            return true;
+        }
+
+        close(errno);
+
+        return false;
+    }
+}
+
+bool Socket::drainErrorQueue() {
+    return readZeroCopyCompletions(fd_, [this](const sock_extended_err &err) {
+        stats_.zeroCopyCompletions += err.ee_data - err.ee_info + 1;
+
+        if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+            ++stats_.zeroCopyCopied;
+        }
+
+        sendQueue_.releaseZeroCopy(err.ee_data);
+    });
+}
+
+void Socket::scheduleFlush() {
+    if (!flushPending_) {
+        flushPending_ = true;
+
+        if (writeCoalescingDelay_.count() > 0) {
+            if (!flushTimer_) {
+                flushTimer_ = std::make_unique<Timer>(loop_);
+                flushTimer_->addExpireCallback([this] { return onFlushTimerExpire(); });
+                flushTimer_->open();
+            }
+
+            flushTimer_->setTime(writeCoalescingDelay_);
+        } else {
+            if (!watcher_->hasFlushCallback()) {
+                watcher_->addFlushCallback([this] { return onWatcherFlush(); });
+            }
+
+            watcher_->scheduleFlush();
+        }
+    }
+
+    if (sendQueue_.size() >= kMaxCoalescedSize) {
+        flush();
+    }
+}
+
+void Socket::checkHighWatermark() {
+    if (state_ != State::kConnected || highWatermark_ == 0 || aboveHighWatermark_) return;
+
+    if (sendQueue_.size() < highWatermark_) return;
+
+    aboveHighWatermark_ = true;
+
+    dispatchHighWatermark();
+}
+
+bool Socket::checkLowWatermark() {
+    if (!aboveHighWatermark_ || sendQueue_.size() > lowWatermark_) return true;
+
+    aboveHighWatermark_ = false;
+
+    dispatchDrained();
+
+    return state_ == State::kConnected;
+}
+
+void Socket::recordRecv(size_t size) {
+    ++stats_.recvCalls;
+    stats_.recvBytes += size;
+}
+
+void Socket::recordSend(size_t size) {
+    ++stats_.sendCalls;
+    stats_.sendBytes += size;
+}
+
+void Socket::adaptRecvChunkSize(size_t chunkSize, size_t size) {
+    if (size >= chunkSize) {
+        adaptiveRecvChunkSize_ = std::min(std::max(adaptiveRecvChunkSize_, size) * 2, kMaxRecvChunkSize);
+        recvShrinkCount_ = 0;
+    } else if (size < adaptiveRecvChunkSize_ / 4) {
+        if (++recvShrinkCount_ >= kRecvShrinkThreshold) {
+            adaptiveRecvChunkSize_ = std::max(adaptiveRecvChunkSize_ / 2, kMinRecvChunkSize);
+            recvShrinkCount_ = 0;
+        }
+    } else {
+        recvShrinkCount_ = 0;
+    }
 }
 
 bool Socket::onWatcherReadReady() {
     LOG(debug, "");
 
+    if (zeroCopy_) {
+        drainErrorQueue();
+    }
+
     if (recvBuffer_.size() == recvBuffer_.maxCapacity()) {
         LOG(warning, "Recv buffer full");
 
@@ -733,41 +1384,98 @@ bool Socket::onWatcherReadReady() {
         return false;
     }
 
-    size_t chunkSize = std::min(recvChunkSize_, recvBuffer_.maxCapacity() - recvBuffer_.size());
-    recvBuffer_.extend(chunkSize);
+    size_t budget = recvBudget_;
+    bool received = false;
+    bool eof = false;
+    int error = 0;
+
+    char extra[kRecvExtraSize];
+
+    while (budget > 0 && recvBuffer_.size() < recvBuffer_.maxCapacity()) {
+        size_t limit = std::min(budget, recvBuffer_.maxCapacity() - recvBuffer_.size());
+        recvBuffer_.reserve(std::min(adaptiveRecvChunkSize_, limit));
+
+        size_t chunkSize = std::min(recvBuffer_.spare(), limit);
+        size_t extraSize = std::min(kRecvExtraSize, limit - chunkSize);
+        recvBuffer_.extend(chunkSize);
+
+        iovec iovs[2];
+        iovs[0].iov_base = recvBuffer_.data() + recvBuffer_.size() - chunkSize;
+        iovs[0].iov_len = chunkSize;
+        iovs[1].iov_base = extra;
+        iovs[1].iov_len = extraSize;
+
+        ssize_t n = readv(fd_, iovs, extraSize > 0 ? 2 : 1);
+        LOG(debug, "readv: n={}", n);
 
-    ssize_t n = recv(fd_, recvBuffer_.data() + recvBuffer_.size() - chunkSize, chunkSize, 0);
-    LOG(debug, "recv: n={}", n);
+        if (n > 0) {
+            if (static_cast<size_t>(n) <= chunkSize) {
+                recvBuffer_.retractBack(chunkSize - n);
+            } else {
+                recvBuffer_.extend(n - chunkSize);
+                memcpy(recvBuffer_.data() + recvBuffer_.size() - (n - chunkSize), extra, n - chunkSize);
+            }
+
+            recordRecv(n);
+            adaptRecvChunkSize(chunkSize, n);
+            budget -= n;
+            received = true;
+
+            if (static_cast<size_t>(n) < chunkSize + extraSize) {
+                watcher_->clearReadReady();
+                break;
+            }
+        } else {
+            recvBuffer_.retractBack(chunkSize);
+
+            if (n == 0) {
+                eof = true;
+                break;
+            }
+
+            LOG(debug, "readv: errno={}", strerrorname_np(errno));
 
-    if (n > 0) {
-        recvBuffer_.retractBack(chunkSize - n);
+            if (errno == EINTR) continue;
 
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watcher_->clearReadReady();
+            } else {
+                error = errno;
+            }
+
+            break;
+        }
+    }
+
+    if (received) {
         const char *data = recvBuffer_.data();
         size_t size = recvBuffer_.size();
         size_t newSize;
 
         dispatchRecv(data, size, newSize);
 
+        if (state_ != State::kConnected) return false;
+
         if (newSize < size) {
             recvBuffer_.retractFront(size - newSize);
             recvActive_ = true;
         }
-    } else {
-        recvBuffer_.retractBack(chunkSize);
 
-        if (n == 0) {
-            close();
+        if (recvBuffer_.empty()) {
+            recvBuffer_.release();
+        }
+    }
 
-            return false;
-        } else {
-            LOG(debug, "recv: errno={}", strerrorname_np(errno));
+    if (eof) {
+        close();
 
-            if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
-                close(errno);
+        return false;
+    }
 
-                return false;
-            }
-        }
+    if (error != 0) {
+        close(error);
+
+        return false;
     }
 
     return true;
@@ -776,36 +1484,45 @@ bool Socket::onWatcherReadReady() {
 bool Socket::onWatcherWriteReady() {
     LOG(debug, "");
 
-    if (!sendBuffer_.empty()) {
-        ssize_t n = ::send(fd_, sendBuffer_.data(), sendBuffer_.size(), MSG_NOSIGNAL);
-        LOG(debug, "send: n={}", n);
+    if (!sendQueue_.empty() && !flushSendQueue()) return false;
 
-        if (n >= 0) {
-            sendBuffer_.retractFront(n);
-        } else {
-            LOG(debug, "send: errno={}", strerrorname_np(errno));
-
-            if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
-                close(errno);
-
-                return false;
-            }
-        }
-    }
+    if (!checkLowWatermark()) return false;
 
-    if (sendBuffer_.empty()) {
+    if (sendQueue_.empty()) {
         dispatchSendComplete();
     }
 
     sendActive_ = true;
 
-    return !sendBuffer_.empty();
+    return !sendQueue_.empty();
+}
+
+bool Socket::onWatcherFlush() {
+    LOG(debug, "");
+
+    flush();
+
+    return state_ == State::kConnected;
+}
+
+bool Socket::onWatcherError() {
+    LOG(debug, "");
+
+    if (zeroCopy_ && drainErrorQueue()) return true;
+
+    int optVal;
+    socklen_t optLen = sizeof(optVal);
+    CHECK(getsockopt(fd_, SOL_SOCKET, SO_ERROR, &optVal, &optLen) == 0);
+
+    close(optVal);
+
+    return false;
 }
 
 bool Socket::onRecvTimerExpire() {
     LOG(debug, "");
 
-    if (!recvBuffer_.empty() && !recvActive_) {
+    if (!recvBuffer_.empty() && !recvActive_ && !recvPaused_) {
         LOG(warning, "Recv timed out");
 
         close(ETIMEDOUT);
@@ -821,7 +1538,7 @@ bool Socket::onRecvTimerExpire() {
 bool Socket::onSendTimerExpire() {
     LOG(debug, "");
 
-    if (!sendBuffer_.empty() && !sendActive_) {
+    if (!sendQueue_.empty() && !sendActive_) {
         LOG(warning, "Send timed out");
 
         close(ETIMEDOUT);
@@ -833,3 +1550,11 @@ bool Socket::onSendTimerExpire() {
 
     return true;
 }
+
+bool Socket::onFlushTimerExpire() {
+    LOG(debug, "");
+
+    flush();
+
+    return state_ == State::kConnected;
+}
@@ -2,12 +2,14 @@
 
 #include "mq/rpc/RpcClient.h"
 
+#include <coroutine>
 #include <cstdint>
 #include <cstring>
 #include <format>
 #include <future>
 #include <iterator>
 #include <limits>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -28,6 +30,23 @@ using namespace mq;
 
 namespace {
 
+Expected<std::string, RpcError> parseReply(std::string_view message) {
+    if (message.size() < 1) {
+        LOG(warning, "Bad reply");
+
+        return RpcError::kBadReply;
+    }
+
+    uint8_t statusCode;
+    memcpy(&statusCode, message.data(), 1);
+
+    RpcError status = static_cast<RpcError>(statusCode);
+
+    if (status != RpcError::kOk) return status;
+
+    return std::string(message.substr(1));
+}
+
 class RecvCallbackImpl {
 public:
     explicit RecvCallbackImpl(std::promise<Expected<std::string, RpcError>> promise)
@@ -45,31 +64,44 @@ public:
     }
 
     void operator()(std::string_view message) {
-        if (message.size() < 1) {
-            LOG(warning, "Bad reply");
-
-            promise_.set_value(RpcError::kBadReply);
-            valid_ = false;
-            return;
-        }
+        promise_.set_value(parseReply(message));
+        valid_ = false;
+    }
 
-        uint8_t statusCode;
-        memcpy(&statusCode, message.data(), 1);
+private:
+    std::promise<Expected<std::string, RpcError>> promise_;
+    bool valid_;
+};
 
-        RpcError status = static_cast<RpcError>(statusCode);
+class AwaitCallbackImpl {
+public:
+    AwaitCallbackImpl(EventLoop *loop,
+                      std::optional<Expected<std::string, RpcError>> *result,
+                      std::coroutine_handle<> handle)
+        : loop_(loop), result_(result), handle_(handle), valid_(true) {}
 
-        if (status != RpcError::kOk) {
-            promise_.set_value(status);
-            valid_ = false;
-            return;
+    ~AwaitCallbackImpl() {
+        if (valid_) {
+            result_->emplace(RpcError::kCancelled);
+            loop_->post([handle = handle_] { handle.resume(); });
         }
+    }
 
-        promise_.set_value(std::string(message.substr(1)));
+    AwaitCallbackImpl(AwaitCallbackImpl &&other) noexcept
+        : loop_(other.loop_), result_(other.result_), handle_(other.handle_), valid_(other.valid_) {
+        other.valid_ = false;
+    }
+
+    void operator()(std::string_view message) {
+        result_->emplace(parseReply(message));
         valid_ = false;
+        handle_.resume();
     }
 
 private:
-    std::promise<Expected<std::string, RpcError>> promise_;
+    EventLoop *loop_;
+    std::optional<Expected<std::string, RpcError>> *result_;
+    std::coroutine_handle<> handle_;
     bool valid_;
 };
 
@@ -131,3 +163,45 @@ std::future<Expected<std::string, RpcError>> RpcClient::call(MaybeOwnedString me
 
     return future;
 }
+
+RpcClient::CallAwaiter RpcClient::coCall(MaybeOwnedString methodName, MaybeOwnedString payload) {
+    std::vector<MaybeOwnedString> pieces;
+    pieces.reserve(1);
+    pieces.emplace_back(std::move(payload));
+
+    return CallAwaiter(this, std::move(methodName), std::move(pieces));
+}
+
+RpcClient::CallAwaiter RpcClient::coCall(MaybeOwnedString methodName, std::vector<MaybeOwnedString> pieces) {
+    return CallAwaiter(this, std::move(methodName), std::move(pieces));
+}
+
+RpcClient::CallAwaiter::CallAwaiter(RpcClient *client,
+                                    MaybeOwnedString methodName,
+                                    std::vector<MaybeOwnedString> pieces)
+    : client_(client) {
+    LOG(debug, "methodName={}", methodName);
+
+    CHECK(methodName.size() <= std::numeric_limits<uint8_t>::max());
+
+    methodNameLength_ = static_cast<uint8_t>(methodName.size());
+
+    pieces_.reserve(2 + pieces.size());
+    pieces_.emplace_back(reinterpret_cast<const char *>(&methodNameLength_), 1);
+    pieces_.emplace_back(std::move(methodName));
+    pieces_.insert(pieces_.end(),
+                   std::make_move_iterator(pieces.begin()),
+                   std::make_move_iterator(pieces.end()));
+}
+
+void RpcClient::CallAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    LOG(debug, "");
+
+    AwaitCallbackImpl recvCallback(client_->loop(), &result_, handle);
+
+    client_->requester_.send(std::move(pieces_), std::move(recvCallback));
+}
+
+Expected<std::string, RpcError> RpcClient::CallAwaiter::await_resume() {
+    return std::move(*result_);
+}
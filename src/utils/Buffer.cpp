@@ -10,6 +10,8 @@
 #include <cstring>
 #include <utility>
 
+#include "mq/utils/BufferPool.h"
+
 using namespace mq;
 
 Buffer::Buffer(size_t maxCapacity)
@@ -17,13 +19,15 @@ Buffer::Buffer(size_t maxCapacity)
       capacity_(0),
       begin_(0),
       end_(0),
-      buffer_(nullptr) {}
+      buffer_(nullptr),
+      pool_(nullptr) {}
 
 Buffer::Buffer(const Buffer &other)
     : maxCapacity_(other.maxCapacity_),
       capacity_(other.end_ - other.begin_),
       begin_(0),
-      end_(other.end_ - other.begin_) {
+      end_(other.end_ - other.begin_),
+      pool_(nullptr) {
     buffer_ = static_cast<char *>(malloc(other.end_ - other.begin_));
 
     if (!buffer_) {
@@ -39,7 +43,11 @@ Buffer::Buffer(Buffer &&other) noexcept : Buffer() {
 }
 
 Buffer::~Buffer() {
-    free(buffer_);
+    if (pool_ && buffer_) {
+        pool_->deallocate(buffer_, capacity_);
+    } else {
+        free(buffer_);
+    }
 }
 
 Buffer &Buffer::operator=(Buffer other) noexcept {
@@ -53,6 +61,12 @@ void Buffer::setMaxCapacity(size_t maxCapacity) {
     maxCapacity_ = maxCapacity;
 }
 
+void Buffer::setPool(BufferPool *pool) {
+    assert(capacity_ == 0);
+
+    pool_ = pool;
+}
+
 void Buffer::extend(size_t size) {
     assert(end_ - begin_ + size <= maxCapacity_);
 
@@ -126,6 +140,23 @@ void Buffer::shrinkToFit() {
     }
 }
 
+void Buffer::release() {
+    assert(begin_ == end_);
+
+    if (!buffer_) return;
+
+    if (pool_) {
+        pool_->deallocate(buffer_, capacity_);
+    } else {
+        free(buffer_);
+    }
+
+    capacity_ = 0;
+    begin_ = 0;
+    end_ = 0;
+    buffer_ = nullptr;
+}
+
 void Buffer::swap(Buffer &other) noexcept {
     using std::swap;
     swap(maxCapacity_, other.maxCapacity_);
@@ -133,11 +164,42 @@ void Buffer::swap(Buffer &other) noexcept {
     swap(begin_, other.begin_);
     swap(end_, other.end_);
     swap(buffer_, other.buffer_);
+    swap(pool_, other.pool_);
 }
 
 void Buffer::reallocate(size_t newCapacity) {
     size_t size = end_ - begin_;
 
+    if (pool_) {
+        if (newCapacity == 0) {
+            release();
+            return;
+        }
+
+        if (buffer_ && BufferPool::roundUp(newCapacity) == capacity_) {
+            move();
+            return;
+        }
+
+        char *newBuffer = pool_->allocate(newCapacity);
+
+        if (buffer_) {
+            memcpy(newBuffer, buffer_ + begin_, size);
+            pool_->deallocate(buffer_, capacity_);
+        }
+
+#ifndef NDEBUG
+        memset(newBuffer + size, 0xcc, newCapacity - size);
+#endif
+
+        capacity_ = newCapacity;
+        begin_ = 0;
+        end_ = size;
+        buffer_ = newBuffer;
+
+        return;
+    }
+
     char *newBuffer = static_cast<char *>(realloc(buffer_, newCapacity));
 
     if (!newBuffer) {
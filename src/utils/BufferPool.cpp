@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/utils/BufferPool.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace mq;
+
+namespace {
+
+char *allocateBlock(size_t size) {
+    char *data = static_cast<char *>(malloc(size));
+
+    if (!data) {
+        perror("malloc");
+        abort();
+    }
+
+    return data;
+}
+
+size_t sizeClassOf(size_t size) {
+    return std::bit_width(size - 1) - BufferPool::kMinSizeClassShift;
+}
+
+} // namespace
+
+BufferPool::BufferPool(size_t budget)
+    : budget_(budget) {}
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+void BufferPool::setBudget(size_t budget) {
+    budget_ = budget;
+
+    trim(budget_);
+}
+
+char *BufferPool::allocate(size_t &size) {
+    size = roundUp(size);
+
+    ++stats_.allocations;
+    stats_.inUseBytes += size;
+
+    if (size > (size_t(1) << kMaxSizeClassShift)) {
+        return allocateBlock(size);
+    }
+
+    size_t sizeClass = sizeClassOf(size);
+
+    if (FreeBlock *block = freeLists_[sizeClass]) {
+        freeLists_[sizeClass] = block->next;
+        ++stats_.hits;
+        stats_.pooledBytes -= size;
+        return reinterpret_cast<char *>(block);
+    }
+
+    return allocateBlock(size);
+}
+
+void BufferPool::deallocate(char *data, size_t size) {
+    ++stats_.deallocations;
+    stats_.inUseBytes -= size;
+
+    if (size > (size_t(1) << kMaxSizeClassShift) || stats_.pooledBytes + size > budget_) {
+        ++stats_.evictions;
+        free(data);
+        return;
+    }
+
+    size_t sizeClass = sizeClassOf(size);
+
+    FreeBlock *block = reinterpret_cast<FreeBlock *>(data);
+    block->next = freeLists_[sizeClass];
+    freeLists_[sizeClass] = block;
+    stats_.pooledBytes += size;
+}
+
+void BufferPool::trim(size_t budget) {
+    for (size_t i = kNumSizeClasses; i-- > 0 && stats_.pooledBytes > budget;) {
+        size_t size = size_t(1) << (i + kMinSizeClassShift);
+
+        while (FreeBlock *block = freeLists_[i]) {
+            if (stats_.pooledBytes <= budget) break;
+
+            freeLists_[i] = block->next;
+            stats_.pooledBytes -= size;
+            ++stats_.evictions;
+            free(block);
+        }
+    }
+}
+
+size_t BufferPool::roundUp(size_t size) {
+    if (size <= (size_t(1) << kMinSizeClassShift)) {
+        return size_t(1) << kMinSizeClassShift;
+    }
+
+    if (size > (size_t(1) << kMaxSizeClassShift)) {
+        return size;
+    }
+
+    return std::bit_ceil(size);
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/utils/Cycles.h"
+
+#include <chrono>
+#include <cstdint>
+
+using namespace mq;
+
+double mq::nanosecondsPerCycle() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double value = [] {
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point startTime = Clock::now();
+        uint64_t startCycles = readCycles();
+
+        Clock::time_point endTime;
+
+        do {
+            endTime = Clock::now();
+        } while (endTime - startTime < std::chrono::milliseconds(1));
+
+        uint64_t endCycles = readCycles();
+
+        std::chrono::nanoseconds elapsed = endTime - startTime;
+
+        return static_cast<double>(elapsed.count()) / static_cast<double>(endCycles - startCycles);
+    }();
+
+    return value;
+#else
+    return 1.0;
+#endif
+}
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: MIT
+
+#include "mq/utils/SendQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <sys/uio.h>
+
+#include "mq/utils/Buffer.h"
+#include "mq/utils/BufferPool.h"
+#include "mq/utils/MaybeOwnedString.h"
+#include "mq/utils/SharedBuffer.h"
+
+using namespace mq;
+
+namespace {
+
+constexpr size_t kMinCopiedSegmentSize = 4096;
+constexpr size_t kMaxCopiedSegmentSize = 65536;
+
+} // namespace
+
+const char *SendQueue::Segment::begin() const {
+    return std::visit([this](const auto &data) { return data.data() + offset; }, data);
+}
+
+size_t SendQueue::Segment::size() const {
+    return std::visit([this](const auto &data) { return data.size() - offset; }, data);
+}
+
+SendQueue::SendQueue(size_t maxSize)
+    : maxSize_(maxSize) {}
+
+void SendQueue::setMaxSize(size_t maxSize) {
+    assert(maxSize >= size_);
+
+    maxSize_ = maxSize;
+}
+
+void SendQueue::setPool(BufferPool *pool) {
+    assert(segments_.empty());
+
+    pool_ = pool;
+}
+
+void SendQueue::append(const char *data, size_t size) {
+    assert(size_ + size <= maxSize_);
+
+    if (size == 0) return;
+
+    size_ += size;
+
+    if (!segments_.empty()) {
+        Buffer *tail = std::get_if<Buffer>(&segments_.back().data);
+
+        if (tail && !segments_.back().pinned) {
+            if (tail->size() + size <= kMaxCopiedSegmentSize) {
+                tail->extend(size);
+                memcpy(tail->data() + tail->size() - size, data, size);
+                return;
+            }
+        }
+    }
+
+    Buffer copy;
+    copy.setPool(pool_);
+    copy.reserve(std::max(size, kMinCopiedSegmentSize));
+    copy.extend(size);
+    memcpy(copy.data(), data, size);
+
+    segments_.emplace_back(std::move(copy), 0);
+}
+
+void SendQueue::append(MaybeOwnedString data, size_t offset) {
+    assert(offset <= data.size());
+    assert(size_ + data.size() - offset <= maxSize_);
+
+    if (offset == data.size()) return;
+
+    std::move(data).visit([this, offset](auto &&data) {
+        using T = std::remove_cvref_t<decltype(data)>;
+
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            append(data.data() + offset, data.size() - offset);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            // A short string stores its bytes inline, and they would move with the segment while a
+            // zero-copy send still references them.
+            const char *object = reinterpret_cast<const char *>(&data);
+
+            if (data.data() >= object && data.data() < object + sizeof(data)) {
+                append(data.data() + offset, data.size() - offset);
+            } else {
+                size_ += data.size() - offset;
+                segments_.emplace_back(std::move(data), offset);
+            }
+        } else {
+            size_ += data.size() - offset;
+            segments_.emplace_back(std::move(data), offset);
+        }
+    });
+}
+
+size_t SendQueue::fill(iovec *iovs, size_t maxIovecs) const {
+    size_t n = std::min(segments_.size(), maxIovecs);
+
+    for (size_t i = 0; i < n; ++i) {
+        iovs[i].iov_base = const_cast<char *>(segments_[i].begin());
+        iovs[i].iov_len = segments_[i].size();
+    }
+
+    return n;
+}
+
+void SendQueue::consume(size_t size) {
+    consume(size, false, 0);
+}
+
+void SendQueue::consumeZeroCopy(size_t size, uint32_t id) {
+    consume(size, true, id);
+}
+
+void SendQueue::releaseZeroCopy(uint32_t id) {
+    std::erase_if(retired_, [id](const Segment &segment) {
+        return static_cast<int32_t>(segment.pinId - id) <= 0;
+    });
+}
+
+void SendQueue::moveRetiredTo(SendQueue &other) {
+    retirePinned();
+
+    for (Segment &segment : retired_) {
+        other.retired_.emplace_back(std::move(segment));
+    }
+
+    retired_.clear();
+}
+
+// Pinned segments may still be referenced by the kernel, so they are retired rather than dropped, and
+// retired segments are kept until released or moved out.
+void SendQueue::clear() {
+    retirePinned();
+
+    segments_.clear();
+    size_ = 0;
+}
+
+std::string SendQueue::toString() const {
+    std::string result;
+    result.reserve(size_);
+
+    for (const Segment &segment : segments_) {
+        result.append(segment.begin(), segment.size());
+    }
+
+    return result;
+}
+
+// Moves segments that a zero-copy send has partly handed to the kernel into the retired list. Their unsent
+// bytes are dropped from the queue.
+void SendQueue::retirePinned() {
+    for (Segment &segment : segments_) {
+        if (segment.pinned) {
+            size_ -= segment.size();
+            retired_.emplace_back(std::move(segment));
+        }
+    }
+
+    std::erase_if(segments_, [](const Segment &segment) { return segment.pinned; });
+}
+
+void SendQueue::consume(size_t size, bool zeroCopy, uint32_t id) {
+    assert(size <= size_);
+
+    size_ -= size;
+
+    while (size > 0) {
+        Segment &segment = segments_.front();
+        size_t segmentSize = segment.size();
+
+        if (zeroCopy) {
+            segment.pinned = true;
+            segment.pinId = id;
+        }
+
+        if (size < segmentSize) {
+            segment.offset += size;
+            break;
+        }
+
+        size -= segmentSize;
+
+        if (segment.pinned) {
+            retired_.emplace_back(std::move(segment));
+        }
+
+        segments_.pop_front();
+    }
+}